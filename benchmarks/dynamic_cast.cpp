@@ -149,15 +149,9 @@ NONIUS_BENCHMARK("hierarchy match level 2 -> level 1", []
    escape_from_optimizer(ni::match(*p)([](H1a const&){}));
 });
 
-
-//  This case currently does not work, since there is a certain compile time
-//  safety of the hierarchy & match framework. This would only work if dyn_cast
-//  would use reinterpret_cast instead of static_cast. Leaving this in for now,
-//  in case future scenario pop up where this is required.
-//
-//  NONIUS_BENCHMARK("hierarchy fail level 2 -> level 1", []
-//  {
-//     H2a const* p = &h2a;
-//     escape_from_optimizer(p);
-//     escape_from_optimizer(ni::match(*p)([](H1b const&){}));
-//  });
+NONIUS_BENCHMARK("hierarchy fail level 2 -> level 1", []
+{
+   H2a const* p = &h2a;
+   escape_from_optimizer(p);
+   escape_from_optimizer(ni::match(*p)([](H1b const&){}));
+});
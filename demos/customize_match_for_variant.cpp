@@ -9,32 +9,15 @@
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
 
 #include <ni/functional/match.h>
-#include <vector>
-#include <variant>
-#include <string>
-#include <iostream>
+#include <ni/functional/matchable_variant.h>
 
+#include <iostream>
+#include <string>
 #include <variant>
+#include <vector>
 
-namespace std
-{
-    // Customization point of ni::match for std::variant
-    // However, this does not do an efficient match on variants
-    // because ni::match does a linear search on the types of the match.
-    // std::visit uses a function table which matches in O(1) time.
-
-    template <typename Target, typename... Ts>
-    Target const* dyn_cast(variant<Ts...> const* v)
-    {
-        return get_if<Target>(v);
-    }
-
-    template <typename Target, typename... Ts>
-    Target* dyn_cast(variant<Ts...>* v)
-    {
-        return get_if<Target>(v);
-    }
-}
+// ni/functional/matchable_variant.h provides the customization points of ni::match for std::variant. The case is
+// selected with a switch over the index of the variant, so the match is O(1) like std::visit.
 
 
 int main()
@@ -52,4 +35,15 @@ int main()
         );
         std::cout << x << std::endl;
     }
+
+    // a case for each alternative, the result isn't optional
+    for (auto const& var : vars)
+    {
+        int n = ni::match(var)
+        (   [](double)  { return 1; }
+        ,   [](int)     { return 2; }
+        ,   [](MyType)  { return 3; }
+        );
+        std::cout << n << std::endl;
+    }
 }
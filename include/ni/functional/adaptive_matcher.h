@@ -0,0 +1,286 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+
+//!---------------------------------------------------------------------------------------------------------------------
+//!
+//!  \file
+//!
+//!  `ni::adaptive_matcher` and `ni::adaptive_match` take the same cases as `ni::matcher` and `ni::match`, but try
+//!   them in the order of their observed frequency instead of the order of the source. They are meant for types that
+//!   can't select the case with a table, e.g. plain virtual hierarchies, for which `ni::match` tries one case after
+//!   another.
+//!
+//!   Every 64th match of a thread is sampled, and after 256 samples of a call site the order of its cases is
+//!   recomputed with the most frequent cases first. The counts decay with each reordering, so the order follows
+//!   changes of the workload. The order is learned per call site, i.e. per list of lambdas, and per type of the
+//!   matched object. Reading the order is a single relaxed atomic load, reordering happens under a lock that
+//!   matches never wait for.
+//!
+//!   The result is the same as with `ni::match`: a case is only moved in front of an earlier case if no object can
+//!   match both. Targets are disjoint if neither is a base of the other and one of them is final. Sum types can
+//!   prove more via the optional customization point `dyn_disjoint()`, e.g. type_hierarchy types on different
+//!   branches or different types stored in a `std::any` are always disjoint.
+//!
+//!   template <typename Target1, typename Target2>
+//!   std::integral_constant<bool, ...> dyn_disjoint(ni::meta::type_list<Target1, Target2>, CustomType const* p);
+//!
+//!   Example
+//!   ```
+//!     for (auto const& e : events)
+//!         ni::adaptive_match(*e)
+//!         (   [this](mouse_up const& e)    { handle_mouse_up(e); }
+//!         ,   [this](mouse_down const& e)  { handle_mouse_down(e); }
+//!         ,   [this](mouse_move const& e)  { handle_mouse_move(e); }    // tried first if it's the most frequent
+//!         );
+//!   ```
+//!
+//!   Matching on pairs of objects is not supported, since it already selects the case with a table.
+//!
+//!---------------------------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <ni/functional/match.h>
+
+#include <boost/optional.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+
+namespace ni
+{
+
+    namespace detail
+    {
+        constexpr std::size_t max_adaptive_cases = 16;
+        constexpr std::uint32_t adaptive_sample_period = 64;
+        constexpr std::uint32_t adaptive_reorder_samples = 256;
+
+
+        // case_precedence<>::before[j] has the bit i set if case i has to be tried before case j
+        template <typename Type, typename... Targets>
+        struct case_precedence
+        {
+            static constexpr std::size_t size = sizeof...(Targets);
+
+            template <typename Target>
+            static constexpr index_array<size, bool> disjoint_to()
+            {
+                return {{ targets_disjoint<std::remove_cv_t<Target>, std::remove_cv_t<Targets>>
+                          (meta::try_t{}, static_cast<std::remove_cv_t<Type> const*>(nullptr))... }};
+            }
+
+            static constexpr index_array<size, bool> is_disjoint[] = { disjoint_to<Targets>()... };
+
+            static constexpr index_array<size, std::uint32_t> make_before()
+            {
+                index_array<size, std::uint32_t> result{};
+                for (std::size_t j = 0; j < size; ++j)
+                    for (std::size_t i = 0; i < j; ++i)
+                        if (not is_disjoint[i].data[j])
+                            result.data[j] |= std::uint32_t(1) << i;
+                return result;
+            }
+
+            static constexpr index_array<size, std::uint32_t> before = make_before();
+        };
+
+        template <typename Type, typename... Targets>
+        constexpr index_array<case_precedence<Type, Targets...>::size, bool> case_precedence<Type, Targets...>::is_disjoint[];
+
+        template <typename Type, typename... Targets>
+        constexpr index_array<case_precedence<Type, Targets...>::size, std::uint32_t> case_precedence<Type, Targets...>::before;
+
+
+        // the order in which the cases are tried, 4 bits per position
+        template <std::size_t NumCases>
+        class adaptive_order
+        {
+        public:
+
+            using order_t = std::uint64_t;
+
+            static constexpr order_t source_order()
+            {
+                order_t order = 0;
+                for (std::size_t k = 0; k < NumCases; ++k)
+                    order |= order_t(k) << (4 * k);
+                return order;
+            }
+
+            order_t load() const noexcept
+            {
+                return m_order.load(std::memory_order_relaxed);
+            }
+
+            //! Records a sample of case k, `NumCases` for misses, and reorders the cases every now and then
+            void sample(std::size_t k, std::uint32_t const* before)
+            {
+                m_hits[k].fetch_add(1, std::memory_order_relaxed);
+                if (m_samples.fetch_add(1, std::memory_order_relaxed) + 1 < adaptive_reorder_samples)
+                    return;
+
+                std::unique_lock<std::mutex> lock{m_mutex, std::try_to_lock};
+                if (lock.owns_lock())
+                    reorder(before);
+            }
+
+        private:
+
+            // greedy topological sort: the most frequent case whose predecessors are placed comes next
+            void reorder(std::uint32_t const* before)
+            {
+                std::uint32_t hits[NumCases];
+                for (std::size_t k = 0; k < NumCases; ++k)
+                    hits[k] = m_hits[k].load(std::memory_order_relaxed);
+
+                order_t order = 0;
+                std::uint32_t placed = 0;
+                for (std::size_t pos = 0; pos < NumCases; ++pos)
+                {
+                    std::size_t best = NumCases;
+                    for (std::size_t k = 0; k < NumCases; ++k)
+                        if ((placed & (std::uint32_t(1) << k)) == 0 and (before[k] & ~placed) == 0)
+                            if (best == NumCases or hits[k] > hits[best])
+                                best = k;
+
+                    placed |= std::uint32_t(1) << best;
+                    order |= order_t(best) << (4 * pos);
+                }
+                m_order.store(order, std::memory_order_relaxed);
+
+                for (auto& h : m_hits)
+                    h.store(h.load(std::memory_order_relaxed) / 2, std::memory_order_relaxed);
+                m_samples.store(0, std::memory_order_relaxed);
+            }
+
+            std::atomic<order_t>        m_order{source_order()};
+            std::atomic<std::uint32_t>  m_hits[NumCases + 1] = {};
+            std::atomic<std::uint32_t>  m_samples{0};
+            std::mutex                  m_mutex;
+        };
+
+        inline bool adaptive_sample_tick()
+        {
+            thread_local std::uint32_t tick = 0;
+            return ++tick % adaptive_sample_period == 0;
+        }
+
+
+        template <typename ResultTypeInfo, typename Type, typename... Lambdas>
+        struct adaptive_dispatcher
+        {
+            using result_t = typename ResultTypeInfo::result_t;
+            using cases_t = cases<Lambdas...>;
+            using slot_t = boost::optional<result_t>;
+            using probe_t = bool (*)(Type*, slot_t&, Lambdas&...);
+
+            static_assert( cases_t::size <= max_adaptive_cases, "Adaptive matchers support at most 16 cases." );
+
+            // tries case K, the result is stored in the slot if it matches
+            template <std::size_t K>
+            static bool probe(Type* x, slot_t& slot, Lambdas&... ls)
+            {
+                using target_t = typename cases_t::template target_t<K>;
+                auto* p = matcher_dyn_cast(meta::try_t{}, target_type<target_t>{}, x);
+                if (not p)
+                    return false;
+
+                auto& l = std::get<lambda_index_of_case<Lambdas...>(K)>(std::tie(ls...));
+                slot.emplace(invoker<typename ResultTypeInfo::wrapped_result_t>::apply(l, *p));
+                return true;
+            }
+
+            template <typename... Targets>
+            static std::uint32_t const* precedence(meta::type_list<Targets...>)
+            {
+                return case_precedence<Type, Targets...>::before.data;
+            }
+
+            template <std::size_t... Ks>
+            static result_t apply(std::index_sequence<Ks...>, Type* x, Lambdas&... ls)
+            {
+                static constexpr probe_t probes[] = { &probe<Ks>... };
+                static adaptive_order<cases_t::size> order;
+
+                auto const current = order.load();
+                slot_t slot;
+                std::size_t k = cases_t::size;
+                for (std::size_t pos = 0; pos < cases_t::size; ++pos)
+                {
+                    auto const candidate = static_cast<std::size_t>((current >> (4 * pos)) & 0xf);
+                    if (probes[candidate](x, slot, ls...))
+                    {
+                        k = candidate;
+                        break;
+                    }
+                }
+
+                if (adaptive_sample_tick())
+                    order.sample(k, precedence(typename cases_t::target_list{}));
+
+                if (k == cases_t::size)
+                    return case_invoker<ResultTypeInfo, Type, Lambdas...>::invoke_default(x, ls...);
+                return std::move(*slot);
+            }
+        };
+
+        template <typename ResultTypeInfo, typename Type, typename... Lambdas>
+        auto adaptive_dispatch(Type* x, Lambdas&... ls) -> typename ResultTypeInfo::result_t
+        {
+            return adaptive_dispatcher<ResultTypeInfo, Type, Lambdas...>::apply
+            (   std::make_index_sequence<cases<Lambdas...>::size>{}, x, ls... );
+        }
+    }
+
+
+    template <typename... Lambdas>
+    auto adaptive_matcher(Lambdas&&... lambdas)
+    {
+        using result_info_t = ::ni::detail::result_type_info<Lambdas...>;
+
+        static_assert(
+            meta::fold_and_v<
+                (   (signature<Lambdas>::number_of_arguments == 0)
+                or  (signature<Lambdas>::number_of_arguments == 1)
+                )...
+            >
+            and result_info_t::arity == 1
+            , "Adaptive matchers only match on lambdas with one argument."
+        );
+
+        static_assert(
+            result_info_t::number_of_defaults <= 1
+            , "There can be only one default value defined per matcher."
+        );
+
+        return [=](auto& x) -> typename result_info_t::result_t
+        {
+            return ::ni::detail::adaptive_dispatch<result_info_t>(&x, lambdas...);
+        };
+    }
+
+
+    template <typename Type>
+    auto adaptive_match(Type& x)
+    {
+        return [&x](auto&&... lambdas) -> decltype(auto)
+        {
+            return ::ni::adaptive_matcher(std::forward<decltype(lambdas)>(lambdas)...)(x);
+        };
+    }
+
+}
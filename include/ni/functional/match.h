@@ -59,17 +59,57 @@
 //!
 //!   ```
 //!
+//!   `ni::match` can also match on pairs of objects with lambdas taking two arguments. The most specific case is
+//!   selected, i.e. the case whose argument types have the most super types among the listed argument types. Ties
+//!   are resolved by the order of the cases. If any two argument types of the same argument are either related or
+//!   disjoint, each object is classified once and a table computed at compile time maps both classes to the case.
+//!   Otherwise, e.g. for interfaces an object may implement both of, all cases are probed. Targets are disjoint if
+//!   one of them is final or if the optional customization point `dyn_disjoint()` says so, see adaptive_matcher.h.
+//!
+//!   Example
+//!   ```
+//!     ni::match(tool, target)
+//!     (   [](brush const& b, layer& l)        { … }
+//!     ,   [](brush const& b, mask_layer& m)   { … }     // more specific than the case above
+//!     ,   [](tool const& t, layer& l)         { … }
+//!     ,   []                                  { … }
+//!     );
+//!   ```
+//!
+//!   Sum types select the case in O(1) instead of trying one case after another if they provide one of the optional
+//!   customization points `dyn_case()`, or `dyn_key()` together with `dyn_closed()`. For the latter the table from
+//!   the key of the dynamic type to the case is computed at compile time.
+//!
+//!   Cases that are decided by the static type of the object cost nothing at runtime. A case whose argument is the
+//!   static type or one of its bases is called directly and ends the match, cases that can never match, e.g. types
+//!   on other branches of a `type_hierarchy`, are dropped. Defining `NI_MATCH_DIAGNOSE_SHADOWED_CASES` turns cases
+//!   after a case that always matches into a compile error.
+//!
+//!   Defining `NI_MATCH_INSTRUMENTATION` counts how often each case of each call site is taken, see match_stats.h.
+//!
 //!---------------------------------------------------------------------------------------------------------------------
 
 #pragma once
 
 #include <ni/functional/signature.h>
+#include <ni/meta/fold_and.h>
 #include <ni/meta/fold_or.h>
 #include <ni/meta/fold_add.h>
 #include <ni/meta/try_catch.h>
+#include <ni/meta/type_list.h>
 
+#include <boost/assert.hpp>
 #include <boost/optional.hpp>
 
+#if defined(NI_MATCH_INSTRUMENTATION)
+    #include <ni/functional/match_stats.h>
+#endif
+
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <utility>
+
 
 namespace ni
 {
@@ -85,6 +125,47 @@ namespace ni
     template <typename> void dyn_cast();
 
 
+    //  dyn_case() is an optional customization point for sum types that are able to select the matching case in
+    //  O(1), e.g. via a table lookup, instead of trying each case with dyn_cast<>. It receives the target types of
+    //  all cases in order and returns the index of the first target type the object is convertible to or the number
+    //  of target types if there is none. The object is then casted with static_cast if possible, else with dyn_cast<>.
+    //
+    //  template <typename... TargetTypes>
+    //  std::size_t dyn_case(ni::meta::type_list<TargetTypes...>, CustomType const* p) { return p->case_of<...>(); }
+
+
+    //  dyn_cast_never<>() is an optional customization point that tells at compile time that dyn_cast<TargetType>
+    //  fails for every object of the static type, e.g. for types on different branches of a tree. Such cases are
+    //  dropped. Cases whose target is the static type or one of its bases are always taken without a dyn_cast<>.
+    //
+    //  template <typename TargetType>
+    //  std::integral_constant<bool, ...> dyn_cast_never(CustomType const* p);
+
+    template <typename> void dyn_cast_never();
+
+
+    //  dyn_closed() is an optional customization point that lists the dynamic types objects of the static type can
+    //  have. A match with a case for each of them is exhaustive: it returns the result without an optional, and an
+    //  object matching no case is a bug.
+    //
+    //  ni::meta::type_list<Types...> dyn_closed(CustomType const* p);
+
+
+    //  dyn_key() is an optional customization point for sum types that know their dynamic type as a dense key, e.g.
+    //  the index of a variant or the tag of a tagged union. It returns the index of the dynamic type in the list of
+    //  dyn_closed(), which defines the key of each type at compile time. ni::match then selects the case via a table
+    //  computed at compile time per list of targets. The object is expected to match exactly the targets that are
+    //  the type of its key or its bases. Objects without a type, e.g. valueless variants, return a key out of range.
+    //  The matched object is casted to the type of its key, with static_cast if possible, else with dyn_cast<>.
+    //
+    //  std::size_t dyn_key(CustomType const* p) { return p->tag; }
+    //
+    //  An exhaustive match has no result for keys out of range. It calls the optional dyn_key_out_of_range(), which
+    //  may throw, e.g. std::bad_variant_access like std::visit. Without it, a key out of range is a bug.
+    //
+    //  [[noreturn]] void dyn_key_out_of_range(CustomType const* p);
+
+
 
     namespace detail
     {
@@ -103,6 +184,92 @@ namespace ni
             return dynamic_cast<TargetType*>(p);
         }
 
+        // Cases decided at compile time. A case always matches if its target is the static type of the object or one
+        // of its bases. It never matches if dyn_cast_never<>() says so, or, for types without dyn_cast<>, if the
+        // types are unrelated and one of them is final, so no object can be of both types.
+
+        struct always_matches {};
+        struct never_matches {};
+        struct may_match {};
+
+        template <typename TargetType, typename SourceType>
+        auto has_dyn_cast(meta::try_t, SourceType* p) -> decltype(dyn_cast<TargetType>(p), std::true_type());
+
+        template <typename TargetType, typename SourceType>
+        auto has_dyn_cast(meta::catch_t, SourceType*) -> std::false_type;
+
+        template <typename TargetType, typename SourceType>
+        auto never_matches_v(meta::try_t, SourceType const* p) -> decltype(dyn_cast_never<TargetType>(p));
+
+        template <typename TargetType, typename SourceType>
+        auto never_matches_v(meta::catch_t, SourceType const* p) -> std::integral_constant< bool
+        ,   not decltype(has_dyn_cast<TargetType>(meta::try_t{}, p))::value
+            and std::is_class<TargetType>::value and std::is_class<SourceType>::value
+            and not std::is_base_of<TargetType, SourceType>::value
+            and not std::is_base_of<SourceType, TargetType>::value
+            and (std::is_final<TargetType>::value or std::is_final<SourceType>::value)
+        >;
+
+        template <typename TargetType, typename SourceType>
+        using static_case_t = std::conditional_t
+        <   std::is_convertible<SourceType*, TargetType*>::value
+        ,   always_matches
+        ,   std::conditional_t
+            <   decltype(never_matches_v<std::remove_cv_t<TargetType>>
+                         (meta::try_t{}, std::declval<std::remove_cv_t<SourceType> const*>()))::value
+            ,   never_matches
+            ,   may_match
+            >
+        >;
+
+        // Exhaustive matches on closed types, see dyn_closed()
+
+        template <typename Base, typename Derived>
+        using is_base_or_same = std::integral_constant< bool
+        ,   std::is_same<std::remove_cv_t<Base>, std::remove_cv_t<Derived>>::value
+        or  std::is_base_of<std::remove_cv_t<Base>, std::remove_cv_t<Derived>>::value
+        >;
+
+        template <typename Type>
+        auto closed_types(meta::try_t, Type const* x) -> decltype(dyn_closed(x));
+
+        template <typename Type>
+        auto closed_types(meta::catch_t, Type const*) -> void;
+
+        template <typename ClosedType, typename Targets>
+        struct is_covered;
+
+        template <typename ClosedType, typename... Targets>
+        struct is_covered<ClosedType, meta::type_list<Targets...>>
+        :   meta::fold_or<false, is_base_or_same<Targets, ClosedType>::value...>
+        {};
+
+        template <typename Type, typename Targets, typename ClosedTypes>
+        struct is_exhaustive : std::false_type {};
+
+        // if the closed types are sub types of the static type, the ones on other branches can be ignored
+        template <typename Type, typename Targets, typename... ClosedTypes>
+        struct is_exhaustive<Type, Targets, meta::type_list<ClosedTypes...>>
+        {
+            static constexpr bool sub_types = meta::fold_or_v<false, is_base_or_same<Type, ClosedTypes>::value...>;
+
+            static constexpr bool value = meta::fold_and_v
+            <   true
+            ,   (   (sub_types and not is_base_or_same<Type, ClosedTypes>::value)
+                or  is_covered<ClosedTypes, Targets>::value
+                )...
+            >;
+        };
+
+        [[noreturn]] inline void unreachable()
+        {
+        #if defined(_MSC_VER)
+            __assume(0);
+        #else
+            __builtin_unreachable();
+        #endif
+        }
+
         // Some helper type trait
 
         template <typename Function, typename... Functions>
@@ -128,18 +295,56 @@ namespace ni
         struct result_type_info
         {
             static constexpr size_t sum_of_arguments = meta::fold_add_v<size_t, signature<Functions>::number_of_arguments...>;
+            static constexpr size_t number_of_defaults = meta::fold_add_v<size_t, 0, (signature<Functions>::number_of_arguments == 0)...>;
+            static constexpr size_t arity = sizeof...(Functions) > number_of_defaults
+                                          ? sum_of_arguments / (sizeof...(Functions) - number_of_defaults)
+                                          : 0;
             using wrapped_result_t = typename result<Functions...>::type;
             using result_t = std::conditional_t
             <   std::is_same<void,wrapped_result_t>::value
             ,   bool
             ,   std::conditional_t
-                <   sum_of_arguments == size_t(sizeof...(Functions))
+                <   number_of_defaults == 0
                 ,   boost::optional<wrapped_result_t>
                 ,   wrapped_result_t
                 >
             >;
+
+            static constexpr bool exhaustive = false;
+
+            static result_t no_match()
+            {
+                return {};
+            }
         };
 
+        // the result type info of exhaustive matches, the result isn't optional and there are no misses
+        template <typename ResultTypeInfo>
+        struct exhaustive_result_type_info : ResultTypeInfo
+        {
+            using wrapped_result_t = typename ResultTypeInfo::wrapped_result_t;
+            using result_t = std::conditional_t<std::is_void<wrapped_result_t>::value, bool, wrapped_result_t>;
+
+            static constexpr bool exhaustive = true;
+
+            [[noreturn]] static result_t no_match()
+            {
+                BOOST_ASSERT_MSG(false, "The object is none of the types of the closed hierarchy.");
+                unreachable();
+            }
+        };
+
+        template <typename ResultTypeInfo, typename Type, typename Targets>
+        using match_result_type_info_t = std::conditional_t
+        <   is_exhaustive
+            <   Type
+            ,   Targets
+            ,   decltype(closed_types(meta::try_t{}, std::declval<std::remove_cv_t<Type> const*>()))
+            >::value
+        ,   exhaustive_result_type_info<ResultTypeInfo>
+        ,   ResultTypeInfo
+        >;
+
 
         template <typename ResultType>
         struct invoker
@@ -155,6 +360,12 @@ namespace ni
             {
                 return f(a);
             }
+
+            template <typename Function, typename Arg1, typename Arg2>
+            static decltype(auto) apply(Function& f, Arg1& a, Arg2& b)
+            {
+                return f(a, b);
+            }
         };
 
         template <>
@@ -171,10 +382,17 @@ namespace ni
             {
                 return f(a), true;
             }
+
+            template <typename Function, typename Arg1, typename Arg2>
+            static decltype(auto) apply(Function& f, Arg1& a, Arg2& b)
+            {
+                return f(a, b), true;
+            }
         };
 
 
-        // Actual dispatcher. Possible optimization for long lists use hash-map for O(1) lookup
+        // Actual dispatcher, the fallback for types without dyn_case() or dyn_key(). Tries the cases one after
+        // another.
 
         template <typename ResultTypeInfo, typename Type, typename Lambda, typename... Lambdas>
         auto matcher_impl(Type* x, Lambda& l, Lambdas&... ls)
@@ -184,7 +402,7 @@ namespace ni
         template <typename ResultTypeInfo, typename Type>
         auto matcher_impl(Type*) -> typename ResultTypeInfo::result_t
         {
-            return {};
+            return ResultTypeInfo::no_match();
         }
 
         template <typename ResultTypeInfo, typename Type, typename Lambda1, typename Lambda2, typename... Lambdas>
@@ -202,8 +420,25 @@ namespace ni
         }
 
         template <typename ResultTypeInfo, typename Type, typename Lambda, typename... Lambdas>
-        auto matcher_impl(Type* x, Lambda& l, Lambdas&... ls)
-        -> std::enable_if_t< signature<Lambda>::number_of_arguments == 1, typename ResultTypeInfo::result_t>
+        auto matcher_case(always_matches, Type* x, Lambda& l, Lambdas&...) -> typename ResultTypeInfo::result_t
+        {
+        #if defined(NI_MATCH_DIAGNOSE_SHADOWED_CASES)
+            static_assert( meta::fold_and_v<true, (signature<Lambdas>::number_of_arguments == 0)...>
+                         , "The case always matches, the cases after it are never taken."
+                         );
+        #endif
+            using target_t = std::remove_reference_t<typename signature<Lambda>::template argument<0>::type>;
+            return invoker<typename ResultTypeInfo::wrapped_result_t>::apply(l, *static_cast<target_t*>(x));
+        }
+
+        template <typename ResultTypeInfo, typename Type, typename Lambda, typename... Lambdas>
+        auto matcher_case(never_matches, Type* x, Lambda&, Lambdas&... ls) -> typename ResultTypeInfo::result_t
+        {
+            return matcher_impl<ResultTypeInfo>(x,ls...);
+        }
+
+        template <typename ResultTypeInfo, typename Type, typename Lambda, typename... Lambdas>
+        auto matcher_case(may_match, Type* x, Lambda& l, Lambdas&... ls) -> typename ResultTypeInfo::result_t
         {
             using target_t = std::remove_reference_t<typename signature<Lambda>::template argument<0>::type>;
             // TODO add const if Type has const
@@ -212,6 +447,665 @@ namespace ni
             else
                 return matcher_impl<ResultTypeInfo>(x,ls...);
         }
+
+        template <typename ResultTypeInfo, typename Type, typename Lambda, typename... Lambdas>
+        auto matcher_impl(Type* x, Lambda& l, Lambdas&... ls)
+        -> std::enable_if_t< signature<Lambda>::number_of_arguments == 1, typename ResultTypeInfo::result_t>
+        {
+            using target_t = std::remove_reference_t<typename signature<Lambda>::template argument<0>::type>;
+            return matcher_case<ResultTypeInfo>(static_case_t<target_t, Type>{}, x, l, ls...);
+        }
+
+
+        // Table dispatcher for types providing dyn_case() or dyn_key(). The selected case is invoked via a jump table.
+
+        template <typename... Lambdas>
+        constexpr std::size_t lambda_index_of_case(std::size_t k, std::size_t num_arguments = 1)
+        {
+            constexpr std::size_t arguments[] = { 0, signature<Lambdas>::number_of_arguments... };
+            for (std::size_t i = 1; i < sizeof(arguments)/sizeof(arguments[0]); ++i)
+                if (arguments[i] == num_arguments and k-- == 0)
+                    return i - 1;
+            return sizeof...(Lambdas);
+        }
+
+        template <typename... Lambdas>
+        struct cases
+        {
+            static constexpr std::size_t arity = result_type_info<Lambdas...>::arity;
+            static constexpr std::size_t size = sizeof...(Lambdas) - result_type_info<Lambdas...>::number_of_defaults;
+            static constexpr std::size_t default_index = lambda_index_of_case<Lambdas...>(0, 0);
+
+            template <std::size_t K>
+            using lambda_t = std::tuple_element_t<lambda_index_of_case<Lambdas...>(K, arity), std::tuple<Lambdas...>>;
+
+            template <std::size_t K, std::size_t N = 0>
+            using target_t = std::remove_reference_t<typename signature<lambda_t<K>>::template argument<N>::type>;
+
+            template <std::size_t... Ks>
+            static auto targets(std::index_sequence<Ks...>) -> meta::type_list<target_t<Ks>...>;
+
+            using target_list = decltype(targets(std::make_index_sequence<size>{}));
+        };
+
+
+        template <typename TargetType, typename SourceType>
+        using copy_const_t = std::conditional_t<std::is_const<SourceType>::value, TargetType const, TargetType>;
+
+        // Objects with dyn_key() can be casted to targets without dyn_cast<>, e.g. to a base of the alternatives of a
+        // variant, by casting them to the type of their key.
+
+        template <typename TargetType, typename KeyType, typename SourceType>
+        auto key_cast_to(SourceType* p)
+        -> std::enable_if_t<is_base_or_same<TargetType, KeyType>::value, copy_const_t<TargetType, SourceType>*>
+        {
+            return case_cast(meta::try_t{}, target_type<KeyType>{}, p);
+        }
+
+        template <typename TargetType, typename KeyType, typename SourceType>
+        auto key_cast_to(SourceType*)
+        -> std::enable_if_t<not is_base_or_same<TargetType, KeyType>::value, copy_const_t<TargetType, SourceType>*>
+        {
+            return nullptr;
+        }
+
+        template <typename TargetType, typename SourceType, typename... KeyTypes>
+        copy_const_t<TargetType, SourceType>* key_cast(meta::type_list<KeyTypes...>, SourceType* p)
+        {
+            using cast_t = copy_const_t<TargetType, SourceType>* (*)(SourceType*);
+            static constexpr cast_t casts[] = { &key_cast_to<TargetType, KeyTypes, SourceType>..., nullptr };
+            auto const key = static_cast<std::size_t>(dyn_key(p));
+            return key < sizeof...(KeyTypes) ? casts[key](p) : nullptr;
+        }
+
+        template <typename TargetType, typename SourceType>
+        auto checked_cast(meta::try_t, target_type<TargetType> t, SourceType* p)
+        -> decltype(matcher_dyn_cast(meta::try_t{}, t, p))
+        {
+            return matcher_dyn_cast(meta::try_t{}, t, p);
+        }
+
+        template <typename TargetType, typename SourceType>
+        auto checked_cast(meta::catch_t, target_type<TargetType>, SourceType* p)
+        -> decltype(key_cast<TargetType>(dyn_closed(p), p))
+        {
+            return key_cast<TargetType>(decltype(dyn_closed(p)){}, p);
+        }
+
+        // the object is casted with static_cast if possible
+        template <typename TargetType, typename SourceType>
+        auto case_cast(meta::try_t, target_type<TargetType>, SourceType* p)
+        -> decltype(static_cast<copy_const_t<TargetType, SourceType>*>(p))
+        {
+            return static_cast<copy_const_t<TargetType, SourceType>*>(p);
+        }
+
+        template <typename TargetType, typename SourceType>
+        auto case_cast(meta::catch_t, target_type<TargetType> t, SourceType* p)
+        -> decltype(checked_cast(meta::try_t{}, t, p))
+        {
+            return checked_cast(meta::try_t{}, t, p);
+        }
+
+
+        // table_case() selects the case in O(1), via dyn_case() if available, else via dyn_key() and a table that
+        // maps the keys to the first case whose target is the type of the key or one of its bases
+
+        template <typename KeyType, typename... Targets>
+        constexpr std::size_t first_case_of_key(meta::type_list<Targets...>)
+        {
+            constexpr bool matches[] = { is_base_or_same<Targets, KeyType>::value..., true };
+            std::size_t k = 0;
+            while (not matches[k])
+                ++k;
+            return k;
+        }
+
+        template <typename... Targets, typename... KeyTypes, typename Type>
+        std::size_t key_case(meta::type_list<Targets...>, meta::type_list<KeyTypes...>, Type* x)
+        {
+            using targets_t = meta::type_list<Targets...>;
+            static constexpr std::size_t cases[] = { first_case_of_key<KeyTypes>(targets_t{})..., sizeof...(Targets) };
+            auto const key = static_cast<std::size_t>(dyn_key(x));
+            return cases[key < sizeof...(KeyTypes) ? key : sizeof...(KeyTypes)];
+        }
+
+        template <typename Targets, typename Type>
+        auto table_case(meta::try_t, Targets targets, Type* x) -> decltype(dyn_case(targets, x))
+        {
+            return dyn_case(targets, x);
+        }
+
+        template <typename Targets, typename Type>
+        auto table_case(meta::catch_t, Targets targets, Type* x)
+        -> decltype(dyn_key(x), key_case(targets, dyn_closed(x), x))
+        {
+            return key_case(targets, decltype(dyn_closed(x)){}, x);
+        }
+
+
+        // case_index() computes the index of the first case matching x, via table_case() if available.
+
+        template <typename Type>
+        std::size_t first_case(meta::type_list<>, Type*)
+        {
+            return 0;
+        }
+
+        template <typename Target, typename... Targets, typename Type>
+        std::size_t first_case(meta::type_list<Target, Targets...>, Type* x)
+        {
+            return matcher_dyn_cast(meta::try_t{}, target_type<Target>{}, x)
+                ?  0
+                :  1 + first_case(meta::type_list<Targets...>{}, x);
+        }
+
+        template <typename Targets, typename Type>
+        auto case_index(meta::try_t, Targets targets, Type* x) -> decltype(table_case(meta::try_t{}, targets, x))
+        {
+            return table_case(meta::try_t{}, targets, x);
+        }
+
+        template <typename Targets, typename Type>
+        std::size_t case_index(meta::catch_t, Targets targets, Type* x)
+        {
+            return first_case(targets, x);
+        }
+
+
+        // element_pointer() gives access to the elements of ranges for the batch interfaces, pointers and smart pointers
+        // are dereferenced, everything else is taken by address
+        template <typename Element>
+        auto element_pointer(meta::try_t, Element& e) -> decltype(std::addressof(*e))
+        {
+            return e ? std::addressof(*e) : nullptr;
+        }
+
+        template <typename Element>
+        Element* element_pointer(meta::catch_t, Element& e)
+        {
+            return std::addressof(e);
+        }
+
+        template <typename Range>
+        using element_pointer_t = decltype
+        (   element_pointer(meta::try_t{}, std::declval<std::remove_reference_t<decltype(*std::begin(std::declval<Range&>()))>&>())
+        );
+
+
+        template <typename ResultTypeInfo, typename Type, typename... Lambdas>
+        struct case_invoker
+        {
+            using result_t = typename ResultTypeInfo::result_t;
+            using cases_t = cases<Lambdas...>;
+            using function_t = result_t (*)(Type*, Lambdas&...);
+
+            template <std::size_t K>
+            static result_t invoke_case(Type* x, Lambdas&... ls)
+            {
+                using target_t = typename cases_t::template target_t<K>;
+                auto& l = std::get<lambda_index_of_case<Lambdas...>(K)>(std::tie(ls...));
+                return invoker<typename ResultTypeInfo::wrapped_result_t>::apply
+                (   l, *case_cast(meta::try_t{}, target_type<target_t>{}, x) );
+            }
+
+            template <std::size_t D = cases_t::default_index>
+            static auto invoke_default(Type*, Lambdas&... ls) -> std::enable_if_t<D < sizeof...(Lambdas), result_t>
+            {
+                return invoker<typename ResultTypeInfo::wrapped_result_t>::apply(std::get<D>(std::tie(ls...)));
+            }
+
+            template <std::size_t D = cases_t::default_index>
+            static auto invoke_default(Type*, Lambdas&...) -> std::enable_if_t<D == sizeof...(Lambdas), result_t>
+            {
+                return ResultTypeInfo::no_match();
+            }
+
+            template <std::size_t... Ks>
+            static result_t apply(std::index_sequence<Ks...>, std::size_t k, Type* x, Lambdas&... ls)
+            {
+                static constexpr function_t table[] = { &invoke_case<Ks>..., &invoke_default<> };
+                return table[k](x, ls...);
+            }
+        };
+
+        // Dispatcher for types providing dyn_key(). A switch over the keys calls the case of each key directly, so the
+        // compiler can inline small cases. The switch is generated in blocks of 16 keys.
+
+        constexpr std::size_t key_switch_block = 16;
+
+        // dyn_key_out_of_range() is only called if the match has no result for the key
+        template <typename Type>
+        auto key_out_of_range(meta::try_t, std::true_type, Type* x) -> decltype(dyn_key_out_of_range(x))
+        {
+            dyn_key_out_of_range(x);
+        }
+
+        template <typename NoResult, typename Type>
+        void key_out_of_range(meta::catch_t, NoResult, Type*)
+        {}
+
+        template <typename ResultTypeInfo, typename Type, typename KeyTypes, typename... Lambdas>
+        struct key_switch;
+
+        template <typename ResultTypeInfo, typename Type, typename... KeyTypes, typename... Lambdas>
+        struct key_switch<ResultTypeInfo, Type, meta::type_list<KeyTypes...>, Lambdas...>
+        {
+            using result_t = typename ResultTypeInfo::result_t;
+            using cases_t = cases<Lambdas...>;
+
+            static constexpr std::size_t num_keys = sizeof...(KeyTypes);
+
+            template <std::size_t Key>
+            using key_type_t = std::tuple_element_t<Key, std::tuple<KeyTypes...>>;
+
+            template <std::size_t Key>
+            static constexpr std::size_t case_of_key()
+            {
+                return first_case_of_key<key_type_t<Key>>(typename cases_t::target_list{});
+            }
+
+            template <std::size_t Key, std::size_t K = case_of_key<Key>()>
+            static auto invoke_key(Type* x, Lambdas&... ls) -> std::enable_if_t<(K < cases_t::size), result_t>
+            {
+                auto& l = std::get<lambda_index_of_case<Lambdas...>(K)>(std::tie(ls...));
+                return invoker<typename ResultTypeInfo::wrapped_result_t>::apply
+                (   l, *case_cast(meta::try_t{}, target_type<key_type_t<Key>>{}, x) );
+            }
+
+            template <std::size_t Key, std::size_t K = case_of_key<Key>()>
+            static auto invoke_key(Type* x, Lambdas&... ls) -> std::enable_if_t<(K == cases_t::size), result_t>
+            {
+                return case_invoker<ResultTypeInfo, Type, Lambdas...>::invoke_default(x, ls...);
+            }
+
+            template <std::size_t Key>
+            static result_t invoke(Type* x, Lambdas&... ls)
+            {
+                return invoke_key<(Key < num_keys ? Key : 0)>(x, ls...);
+            }
+
+            template <std::size_t Base>
+            static auto apply(std::size_t key, Type* x, Lambdas&... ls) -> std::enable_if_t<(Base < num_keys), result_t>
+            {
+                switch (key - Base)
+                {
+                    case  0: return invoke<Base +  0>(x, ls...);
+                    case  1: if (Base +  1 < num_keys) return invoke<Base +  1>(x, ls...); break;
+                    case  2: if (Base +  2 < num_keys) return invoke<Base +  2>(x, ls...); break;
+                    case  3: if (Base +  3 < num_keys) return invoke<Base +  3>(x, ls...); break;
+                    case  4: if (Base +  4 < num_keys) return invoke<Base +  4>(x, ls...); break;
+                    case  5: if (Base +  5 < num_keys) return invoke<Base +  5>(x, ls...); break;
+                    case  6: if (Base +  6 < num_keys) return invoke<Base +  6>(x, ls...); break;
+                    case  7: if (Base +  7 < num_keys) return invoke<Base +  7>(x, ls...); break;
+                    case  8: if (Base +  8 < num_keys) return invoke<Base +  8>(x, ls...); break;
+                    case  9: if (Base +  9 < num_keys) return invoke<Base +  9>(x, ls...); break;
+                    case 10: if (Base + 10 < num_keys) return invoke<Base + 10>(x, ls...); break;
+                    case 11: if (Base + 11 < num_keys) return invoke<Base + 11>(x, ls...); break;
+                    case 12: if (Base + 12 < num_keys) return invoke<Base + 12>(x, ls...); break;
+                    case 13: if (Base + 13 < num_keys) return invoke<Base + 13>(x, ls...); break;
+                    case 14: if (Base + 14 < num_keys) return invoke<Base + 14>(x, ls...); break;
+                    case 15: if (Base + 15 < num_keys) return invoke<Base + 15>(x, ls...); break;
+                    default: return apply<Base + key_switch_block>(key, x, ls...);
+                }
+                return invoke_out_of_range(x, ls...);
+            }
+
+            template <std::size_t Base>
+            static auto apply(std::size_t, Type* x, Lambdas&... ls) -> std::enable_if_t<(Base >= num_keys), result_t>
+            {
+                return invoke_out_of_range(x, ls...);
+            }
+
+            // keys out of range, e.g. of valueless variants, take the default if there is one
+            static result_t invoke_out_of_range(Type* x, Lambdas&... ls)
+            {
+                using no_result_t = std::integral_constant< bool
+                ,   ResultTypeInfo::exhaustive and cases_t::default_index == sizeof...(Lambdas)
+                >;
+                key_out_of_range(meta::try_t{}, no_result_t{}, x);
+                return case_invoker<ResultTypeInfo, Type, Lambdas...>::invoke_default(x, ls...);
+            }
+        };
+
+
+        // the result is known at compile time if the first case that may match always matches
+        template <typename Type, typename... Targets>
+        constexpr bool statically_decided(meta::type_list<Targets...>)
+        {
+            constexpr bool always[] = { false, std::is_same<static_case_t<Targets, Type>, always_matches>::value... };
+            constexpr bool never[] = { false, std::is_same<static_case_t<Targets, Type>, never_matches>::value... };
+            for (std::size_t k = 1; k <= sizeof...(Targets); ++k)
+                if (not never[k])
+                    return always[k];
+            return true;
+        }
+
+        // objects with dyn_key() and dyn_closed() select the case with a switch over their key
+        template <typename ResultTypeInfo, typename Type, typename... Lambdas>
+        auto matcher_dispatch(meta::dispatch<2>, Type* x, Lambdas&... ls)
+        -> std::enable_if_t
+        <   std::is_integral<decltype(dyn_key(x))>::value
+        and not statically_decided<Type>(typename cases<Lambdas...>::target_list{})
+        ,   decltype(dyn_closed(x), typename ResultTypeInfo::result_t())
+        >
+        {
+            using key_types_t = decltype(dyn_closed(x));
+            return key_switch<ResultTypeInfo, Type, key_types_t, Lambdas...>::template apply<0>
+            (   static_cast<std::size_t>(dyn_key(x)), x, ls... );
+        }
+
+        // matcher_impl() is used if all cases are decided at compile time, it doesn't need to look at the object
+        template <typename ResultTypeInfo, typename Type, typename... Lambdas>
+        auto matcher_dispatch(meta::try_t, Type* x, Lambdas&... ls)
+        -> std::enable_if_t
+        <   std::is_integral<decltype(table_case(meta::try_t{}, typename cases<Lambdas...>::target_list{}, x))>::value
+        and not statically_decided<Type>(typename cases<Lambdas...>::target_list{})
+        ,   typename ResultTypeInfo::result_t
+        >
+        {
+            using cases_t = cases<Lambdas...>;
+            return case_invoker<ResultTypeInfo, Type, Lambdas...>::apply
+            (   std::make_index_sequence<cases_t::size>{}
+            ,   table_case(meta::try_t{}, typename cases_t::target_list{}, x)
+            ,   x, ls...
+            );
+        }
+
+        template <typename ResultTypeInfo, typename Type, typename... Lambdas>
+        auto matcher_dispatch(meta::catch_t, Type* x, Lambdas&... ls) -> typename ResultTypeInfo::result_t
+        {
+            return matcher_impl<ResultTypeInfo>(x, ls...);
+        }
+
+
+        // Dispatcher for two objects. The most specific case whose targets both objects are convertible to is invoked.
+        // A case is more specific than another if it has a higher rank, i.e. the sum over both arguments of the number
+        // of listed target types that are super types of its target. Ties are resolved by the order of the cases.
+        //
+        // If each pair of targets of an argument is either related or disjoint, the targets an object is convertible
+        // to are the super types of the most specific one. Both objects are then classified separately by the most
+        // specific target of their argument they are convertible to, and a table computed at compile time maps the
+        // pair of classes to the case. Otherwise, e.g. for unrelated interfaces of the same object, all cases are
+        // probed.
+
+        // targets_disjoint() tells if no object can match both targets, via dyn_disjoint() if available
+
+        template <typename Target1, typename Target2, typename Type>
+        constexpr auto targets_disjoint(meta::try_t, Type const* x)
+        -> decltype(dyn_disjoint(meta::type_list<Target1, Target2>{}, x), bool())
+        {
+            return decltype(dyn_disjoint(meta::type_list<Target1, Target2>{}, x))::value;
+        }
+
+        template <typename Target1, typename Target2, typename Type>
+        constexpr bool targets_disjoint(meta::catch_t, Type const*)
+        {
+            return not is_base_or_same<Target1, Target2>::value
+               and not is_base_or_same<Target2, Target1>::value
+               and (std::is_final<Target1>::value or std::is_final<Target2>::value);
+        }
+
+        template <typename Type, typename Target, typename... Targets>
+        constexpr bool related_or_disjoint()
+        {
+            return meta::fold_and_v
+            <   (   is_base_or_same<Target, Targets>::value
+                or  is_base_or_same<Targets, Target>::value
+                or  targets_disjoint<Target, Targets>(meta::try_t{}, static_cast<Type const*>(nullptr))
+                )...
+            >;
+        }
+
+        // objects of Type can be classified by the most specific target they are convertible to
+        template <typename Type, typename... Targets>
+        constexpr bool classifiable(meta::type_list<Targets...>)
+        {
+            return meta::fold_and_v
+            <   related_or_disjoint<Type, std::remove_cv_t<Targets>, std::remove_cv_t<Targets>...>()...
+            >;
+        }
+
+        template <std::size_t N, typename Value = std::size_t>
+        struct index_array { Value data[N]; };
+
+        template <typename... Targets>
+        struct target_relations
+        {
+            static constexpr std::size_t size = sizeof...(Targets);
+
+            template <typename Target>
+            static constexpr index_array<size, bool> bases_of()
+            {
+                return {{ is_base_or_same<Targets, Target>::value... }};
+            }
+
+            // is_base[k].data[j]: Targets[j] is the same as or a super type of Targets[k]
+            static constexpr index_array<size, bool> is_base[] = { bases_of<Targets>()... };
+
+            static constexpr std::size_t rank(std::size_t k)
+            {
+                std::size_t r = 0;
+                for (std::size_t j = 0; j < size; ++j)
+                    r += is_base[k].data[j] and not is_base[j].data[k];
+                return r;
+            }
+
+            // the targets ordered by descending rank, i.e. the first target an object is convertible to is the most
+            // specific one
+            static constexpr index_array<size> order()
+            {
+                index_array<size> result{};
+                bool used[size] = {};
+                for (std::size_t n = 0; n < size; ++n)
+                {
+                    std::size_t best = size;
+                    for (std::size_t k = 0; k < size; ++k)
+                        if (not used[k] and (best == size or rank(k) > rank(best)))
+                            best = k;
+                    used[best] = true;
+                    result.data[n] = best;
+                }
+                return result;
+            }
+        };
+
+        template <typename... Targets>
+        constexpr index_array<target_relations<Targets...>::size, bool> target_relations<Targets...>::is_base[];
+
+
+        template <typename... Lambdas>
+        struct pair_cases
+        {
+            using cases_t = cases<Lambdas...>;
+
+            static constexpr std::size_t size = cases_t::size;
+
+            static_assert( size > 0, "Matching on two objects requires at least one case." );
+
+            template <std::size_t N, std::size_t... Ks>
+            static auto relations(std::index_sequence<Ks...>) -> target_relations<typename cases_t::template target_t<Ks, N>...>;
+
+            template <std::size_t N>
+            using relations_t = decltype(relations<N>(std::make_index_sequence<size>{}));
+
+            template <std::size_t N, std::size_t... Is>
+            static auto ordered_targets(std::index_sequence<Is...>)
+            -> meta::type_list<typename cases_t::template target_t<relations_t<N>::order().data[Is], N>...>;
+
+            // the targets of argument N in the order the objects are classified with
+            template <std::size_t N>
+            using ordered_targets_t = decltype(ordered_targets<N>(std::make_index_sequence<size>{}));
+
+            // the most specific of the matching cases, `size` if no case matches
+            static constexpr std::size_t best(index_array<size, bool> matches)
+            {
+                std::size_t best = size;
+                std::size_t best_rank = 0;
+                for (std::size_t k = 0; k < size; ++k)
+                {
+                    if (not matches.data[k])
+                        continue;
+
+                    auto const rank = relations_t<0>::rank(k) + relations_t<1>::rank(k);
+                    if (best == size or rank > best_rank)
+                    {
+                        best = k;
+                        best_rank = rank;
+                    }
+                }
+                return best;
+            }
+
+            // the case for the classes c0 and c1 of both objects, `size` if no case matches
+            static constexpr std::size_t select(std::size_t c0, std::size_t c1)
+            {
+                if (c0 == size or c1 == size)
+                    return size;
+
+                auto const t0 = relations_t<0>::order().data[c0];
+                auto const t1 = relations_t<1>::order().data[c1];
+
+                index_array<size, bool> matches{};
+                for (std::size_t k = 0; k < size; ++k)
+                    matches.data[k] = relations_t<0>::is_base[t0].data[k] and relations_t<1>::is_base[t1].data[k];
+                return best(matches);
+            }
+
+            static constexpr index_array<(size + 1) * (size + 1)> make_table()
+            {
+                index_array<(size + 1) * (size + 1)> table{};
+                for (std::size_t c0 = 0; c0 <= size; ++c0)
+                    for (std::size_t c1 = 0; c1 <= size; ++c1)
+                        table.data[c0 * (size + 1) + c1] = select(c0, c1);
+                return table;
+            }
+
+            static constexpr index_array<(size + 1) * (size + 1)> table = make_table();
+        };
+
+        template <typename... Lambdas>
+        constexpr index_array<(pair_cases<Lambdas...>::size + 1) * (pair_cases<Lambdas...>::size + 1)> pair_cases<Lambdas...>::table;
+
+
+        template <typename ResultTypeInfo, typename Type1, typename Type2, typename... Lambdas>
+        struct pair_case_invoker
+        {
+            using result_t = typename ResultTypeInfo::result_t;
+            using cases_t = cases<Lambdas...>;
+            using function_t = result_t (*)(Type1*, Type2*, Lambdas&...);
+
+            template <std::size_t K>
+            static result_t invoke_case(Type1* x, Type2* y, Lambdas&... ls)
+            {
+                auto& l = std::get<lambda_index_of_case<Lambdas...>(K, 2)>(std::tie(ls...));
+                return invoker<typename ResultTypeInfo::wrapped_result_t>::apply
+                (   l
+                ,   *case_cast(meta::try_t{}, target_type<typename cases_t::template target_t<K, 0>>{}, x)
+                ,   *case_cast(meta::try_t{}, target_type<typename cases_t::template target_t<K, 1>>{}, y)
+                );
+            }
+
+            template <std::size_t D = cases_t::default_index>
+            static auto invoke_default(Type1*, Type2*, Lambdas&... ls) -> std::enable_if_t<D < sizeof...(Lambdas), result_t>
+            {
+                return invoker<typename ResultTypeInfo::wrapped_result_t>::apply(std::get<D>(std::tie(ls...)));
+            }
+
+            template <std::size_t D = cases_t::default_index>
+            static auto invoke_default(Type1*, Type2*, Lambdas&...) -> std::enable_if_t<D == sizeof...(Lambdas), result_t>
+            {
+                return {};
+            }
+
+            template <std::size_t... Ks>
+            static result_t apply(std::index_sequence<Ks...>, std::size_t k, Type1* x, Type2* y, Lambdas&... ls)
+            {
+                static constexpr function_t table[] = { &invoke_case<Ks>..., &invoke_default<> };
+                return table[k](x, y, ls...);
+            }
+        };
+
+        template <typename PairCases, typename Type1, typename Type2>
+        std::size_t pair_case_index(std::true_type, Type1* x, Type2* y)
+        {
+            constexpr auto size = PairCases::size;
+            auto const c0 = case_index(meta::try_t{}, typename PairCases::template ordered_targets_t<0>{}, x);
+            auto const c1 = c0 == size
+                          ? size
+                          : case_index(meta::try_t{}, typename PairCases::template ordered_targets_t<1>{}, y);
+            return PairCases::table.data[c0 * (size + 1) + c1];
+        }
+
+        template <typename PairCases, typename Type1, typename Type2, std::size_t... Ks>
+        std::size_t probe_pair_cases(std::index_sequence<Ks...>, Type1* x, Type2* y)
+        {
+            using cases_t = typename PairCases::cases_t;
+            index_array<PairCases::size, bool> const matches =
+            {{  (   matcher_dyn_cast(meta::try_t{}, target_type<typename cases_t::template target_t<Ks, 0>>{}, x)
+                and matcher_dyn_cast(meta::try_t{}, target_type<typename cases_t::template target_t<Ks, 1>>{}, y)
+                )...
+            }};
+            return PairCases::best(matches);
+        }
+
+        template <typename PairCases, typename Type1, typename Type2>
+        std::size_t pair_case_index(std::false_type, Type1* x, Type2* y)
+        {
+            return probe_pair_cases<PairCases>(std::make_index_sequence<PairCases::size>{}, x, y);
+        }
+
+        template <typename ResultTypeInfo, typename Type1, typename Type2, typename... Lambdas>
+        auto pair_matcher_dispatch(Type1* x, Type2* y, Lambdas&... ls) -> typename ResultTypeInfo::result_t
+        {
+            using pair_cases_t = pair_cases<Lambdas...>;
+            constexpr bool classified = classifiable<Type1>(typename pair_cases_t::template ordered_targets_t<0>{})
+                                    and classifiable<Type2>(typename pair_cases_t::template ordered_targets_t<1>{});
+
+            return pair_case_invoker<ResultTypeInfo, Type1, Type2, Lambdas...>::apply
+            (   std::make_index_sequence<pair_cases_t::size>{}
+            ,   pair_case_index<pair_cases_t>(std::integral_constant<bool, classified>{}, x, y)
+            ,   x, y, ls...
+            );
+        }
+
+
+        template <typename ResultTypeInfo, typename... Lambdas>
+        auto make_matcher(std::integral_constant<std::size_t, 1>, Lambdas const&... lambdas)
+        {
+            return [=](auto& x) -> decltype(auto)
+            {
+                using result_info_t = match_result_type_info_t
+                <   ResultTypeInfo, std::remove_reference_t<decltype(x)>, typename cases<Lambdas...>::target_list >;
+                return ::ni::detail::matcher_dispatch<result_info_t>(meta::dispatch<2>{}, &x, lambdas...);
+            };
+        }
+
+        template <typename ResultTypeInfo, typename... Lambdas>
+        auto make_matcher(std::integral_constant<std::size_t, 2>, Lambdas const&... lambdas)
+        {
+            return [=](auto& x, auto& y) -> typename ResultTypeInfo::result_t
+            {
+                return ::ni::detail::pair_matcher_dispatch<ResultTypeInfo>(&x, &y, lambdas...);
+            };
+        }
+
+    #if defined(NI_MATCH_INSTRUMENTATION)
+
+        // wraps each lambda into a counted_case of the site of the matcher, see match_stats.h
+        template <typename ResultTypeInfo, typename Arity, std::size_t... Ks, typename... Lambdas>
+        auto make_instrumented_matcher(Arity arity, std::index_sequence<Ks...>, Lambdas const&... lambdas)
+        {
+            using site_t = match_site<Lambdas...>;
+            auto m = make_matcher<ResultTypeInfo>(arity, counted_case<site_t, Ks, Lambdas>{lambdas}...);
+            return [m](auto&... xs) -> decltype(auto)
+            {
+                site_t::count_call();
+                return m(xs...);
+            };
+        }
+
+    #endif
     }
 
     template <typename Value>
@@ -224,27 +1118,31 @@ namespace ni
     template <typename... Lambdas>
     auto matcher(Lambdas&&... lambdas)
     {
+        using result_info_t = ::ni::detail::result_type_info<Lambdas...>;
+
+        // a matcher with only a default takes one object
+        constexpr auto arity = result_info_t::arity == 0 ? std::size_t(1) : result_info_t::arity;
         static_assert(
             meta::fold_and_v<
                 (   (signature<Lambdas>::number_of_arguments == 0)
-                or  (signature<Lambdas>::number_of_arguments == 1)
+                or  (signature<Lambdas>::number_of_arguments == arity)
                 )...
             >
-            , "Can only match on lambdas with one argument."
+            and (arity == 1 or arity == 2)
+            , "Can only match on lambdas with one argument or on lambdas with two arguments."
         );
 
-        using result_info_t = ::ni::detail::result_type_info<Lambdas...>;
-
-        constexpr auto num_args = result_info_t::sum_of_arguments;
         static_assert(
-            num_args == sizeof...(Lambdas) or num_args == sizeof...(Lambdas) - 1
+            result_info_t::number_of_defaults <= 1
             , "There can be only one default value defined per matcher."
         );
 
-        return [=](auto& x) -> typename result_info_t::result_t
-        {
-            return ::ni::detail::matcher_impl<result_info_t>(&x, lambdas...);
-        };
+    #if defined(NI_MATCH_INSTRUMENTATION)
+        return ::ni::detail::make_instrumented_matcher<result_info_t>
+        (   std::integral_constant<std::size_t, arity>{}, std::index_sequence_for<Lambdas...>{}, lambdas... );
+    #else
+        return ::ni::detail::make_matcher<result_info_t>(std::integral_constant<std::size_t, arity>{}, lambdas...);
+    #endif
     }
 
 
@@ -266,4 +1164,13 @@ namespace ni
         };
     }
 
+    template <typename Type1, typename Type2>
+    auto match(Type1&& x, Type2&& y)
+    {
+        return [&x, &y](auto&&... lambdas) -> decltype(auto)
+        {
+            return ::ni::matcher(std::forward<decltype(lambdas)>(lambdas)...)(x, y);
+        };
+    }
+
 }
\ No newline at end of file
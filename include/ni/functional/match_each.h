@@ -0,0 +1,202 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+
+//!---------------------------------------------------------------------------------------------------------------------
+//!
+//!  \file
+//!
+//!  `ni::match_each` matches all objects of a range with the same cases as `ni::match` does. Instead of dispatching
+//!   each object on its own, it first computes the case of each object, groups the objects by case with a counting
+//!   sort and then invokes each case in a loop over its group. This replaces the hard to predict branch per object
+//!   with a few well predicted loops, which pays off for large ranges of mixed types.
+//!
+//!   The range can contain objects, raw pointers or smart pointers. Null pointers are skipped. The results of the
+//!   lambdas are ignored, a lambda without arguments is invoked for each object that didn't match any case.
+//!
+//!   By default the order in which the objects of one case are visited is unspecified. `ni::keep_order` keeps the
+//!   original order within each case, which costs a second buffer.
+//!
+//!   Example
+//!   ```
+//!     std::vector<event*> events = {…};
+//!
+//!     ni::match_each(events
+//!     ,   [this](mouse_up const& e)    { handle_mouse_up(e); }
+//!     ,   [this](mouse_down const& e)  { handle_mouse_down(e); }
+//!     ,   []                           { /* all other events */ }
+//!     );
+//!
+//!     ni::match_each(ni::keep_order, events
+//!     ,   [this](mouse_drag const& e)  { handle_mouse_drag(e); }    // in the order of events
+//!     );
+//!   ```
+//!
+//!---------------------------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <ni/functional/match.h>
+#include <ni/meta/fold_and.h>
+
+#include <array>
+#include <utility>
+#include <vector>
+
+
+namespace ni
+{
+
+    struct keep_order_t {};
+    constexpr keep_order_t keep_order{};
+
+
+    namespace detail
+    {
+        template <typename Type, typename... Lambdas>
+        struct batch_matcher
+        {
+            using cases_t = cases<Lambdas...>;
+
+            static constexpr std::size_t num_groups = cases_t::size + 1;
+
+            struct entry
+            {
+                Type*        object;
+                std::size_t  group;
+            };
+
+            using offsets_t = std::array<std::size_t, num_groups + 1>;
+
+            template <typename Range>
+            static offsets_t collect(Range& range, std::vector<entry>& entries)
+            {
+                offsets_t offsets{};
+                for (auto&& e : range)
+                    if (Type* p = element_pointer(meta::try_t{}, e))
+                    {
+                        auto const k = case_index(meta::try_t{}, typename cases_t::target_list{}, p);
+                        entries.push_back({p, k});
+                        ++offsets[k + 1];
+                    }
+
+                for (std::size_t k = 1; k < offsets.size(); ++k)
+                    offsets[k] += offsets[k - 1];
+
+                return offsets;
+            }
+
+            // in-place permutation into groups (american flag sort)
+            static void group_unordered(std::vector<entry>& entries, offsets_t const& offsets)
+            {
+                auto next = offsets;
+                for (std::size_t k = 0; k < num_groups; ++k)
+                    while (next[k] < offsets[k + 1])
+                    {
+                        auto& e = entries[next[k]];
+                        if (e.group == k)
+                            ++next[k];
+                        else
+                            std::swap(e, entries[next[e.group]++]);
+                    }
+            }
+
+            static void group_stable(std::vector<entry>& entries, offsets_t const& offsets)
+            {
+                auto next = offsets;
+                std::vector<entry> grouped(entries.size());
+                for (auto const& e : entries)
+                    grouped[next[e.group]++] = e;
+                entries.swap(grouped);
+            }
+
+            template <std::size_t K>
+            static void loop_case(entry const* first, entry const* last, Lambdas&... ls)
+            {
+                using target_t = typename cases_t::template target_t<K>;
+                auto& l = std::get<lambda_index_of_case<Lambdas...>(K)>(std::tie(ls...));
+                for (; first != last; ++first)
+                    l(*case_cast(meta::try_t{}, target_type<target_t>{}, first->object));
+            }
+
+            template <std::size_t D = cases_t::default_index>
+            static auto loop_default(entry const* first, entry const* last, Lambdas&... ls)
+            -> std::enable_if_t<D < sizeof...(Lambdas)>
+            {
+                auto& l = std::get<D>(std::tie(ls...));
+                for (; first != last; ++first)
+                    l();
+            }
+
+            template <std::size_t D = cases_t::default_index>
+            static auto loop_default(entry const*, entry const*, Lambdas&...)
+            -> std::enable_if_t<D == sizeof...(Lambdas)>
+            {}
+
+            template <std::size_t... Ks>
+            static void apply(std::index_sequence<Ks...>, std::vector<entry> const& entries, offsets_t const& offsets, Lambdas&... ls)
+            {
+                auto const* data = entries.data();
+                int expand[] = { 0, (loop_case<Ks>(data + offsets[Ks], data + offsets[Ks + 1], ls...), 0)... };
+                (void) expand;
+                loop_default(data + offsets[cases_t::size], data + offsets[num_groups], ls...);
+            }
+
+            template <typename Range, typename Group>
+            static void run(Range& range, Group group, Lambdas&... ls)
+            {
+                std::vector<entry> entries;
+                auto const offsets = collect(range, entries);
+                group(entries, offsets);
+                apply(std::make_index_sequence<cases_t::size>{}, entries, offsets, ls...);
+            }
+        };
+
+        template <typename Range, typename... Lambdas>
+        using batch_matcher_t = batch_matcher<std::remove_pointer_t<element_pointer_t<Range>>, std::remove_reference_t<Lambdas>...>;
+
+        template <typename... Lambdas>
+        constexpr void check_match_each_lambdas()
+        {
+            static_assert(
+                meta::fold_and_v<
+                    (   (signature<Lambdas>::number_of_arguments == 0)
+                    or  (signature<Lambdas>::number_of_arguments == 1)
+                    )...
+                >
+                , "Can only match on lambdas with one argument."
+            );
+            static_assert(
+                cases<Lambdas...>::size == sizeof...(Lambdas) or cases<Lambdas...>::size == sizeof...(Lambdas) - 1
+                , "There can be only one default value defined per matcher."
+            );
+        }
+    }
+
+
+    template <typename Range, typename... Lambdas>
+    void match_each(Range&& range, Lambdas&&... lambdas)
+    {
+        ::ni::detail::check_match_each_lambdas<std::remove_reference_t<Lambdas>...>();
+
+        using matcher_t = ::ni::detail::batch_matcher_t<Range, Lambdas...>;
+        matcher_t::run(range, &matcher_t::group_unordered, lambdas...);
+    }
+
+    template <typename Range, typename... Lambdas>
+    void match_each(keep_order_t, Range&& range, Lambdas&&... lambdas)
+    {
+        ::ni::detail::check_match_each_lambdas<std::remove_reference_t<Lambdas>...>();
+
+        using matcher_t = ::ni::detail::batch_matcher_t<Range, Lambdas...>;
+        matcher_t::run(range, &matcher_t::group_stable, lambdas...);
+    }
+
+}
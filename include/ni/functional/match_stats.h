@@ -0,0 +1,451 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+
+//!---------------------------------------------------------------------------------------------------------------------
+//!
+//!  \file
+//!
+//!  `ni::match_stats` records how often each case of each `ni::match` / `ni::matcher` call site is taken. It's
+//!   opt-in: if `NI_MATCH_INSTRUMENTATION` is defined before match.h is included (for the whole program, e.g. on the
+//!   command line) each case counts its hits, otherwise match.h doesn't include this file and the matchers are
+//!   unchanged. With `NI_MATCH_INSTRUMENTATION_CYCLES` the cases also measure the cycles spent in their lambdas,
+//!   including nested matches.
+//!
+//!   A call site is identified by the types of its lambdas, i.e. every `ni::match` expression in the code is a site
+//!   of its own. The counters are thread local and merged when they are read, the counts of threads that exited are
+//!   kept. The sites are named after the type of their first lambda, which contains the enclosing function or the
+//!   source location, depending on the compiler.
+//!
+//!   Example
+//!   ```
+//!     for (auto const& site : ni::match_stats::snapshot())
+//!         if (site.misses > site.calls / 2)
+//!             log("mostly unmatched: ", site.name);
+//!
+//!     ni::match_stats::dump_json(std::cout);
+//!   ```
+//!
+//!   A site misses if none of its cases matched, regardless of whether a default value is provided. `reset()` may
+//!   lose the counts of cases that run concurrently.
+//!
+//!---------------------------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <ni/functional/signature.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(NI_MATCH_INSTRUMENTATION_CYCLES)
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #elif defined(__x86_64__) or defined(__i386__)
+        #include <x86intrin.h>
+    #else
+        #include <chrono>
+    #endif
+#endif
+
+
+namespace ni
+{
+
+    namespace match_stats
+    {
+        struct case_stats
+        {
+            std::string     signature;
+            std::uint64_t   hits = 0;
+            std::uint64_t   cycles = 0;
+            bool            is_default = false;
+        };
+
+        struct site_stats
+        {
+            std::string              name;
+            std::uint64_t            calls = 0;
+            std::uint64_t            misses = 0;
+            std::vector<case_stats>  cases;
+        };
+
+        //! The merged counters of all sites that were called so far
+        std::vector<site_stats> snapshot();
+
+        //! Sets all counters to zero
+        void reset();
+
+        void dump_text(std::ostream& out);
+        void dump_json(std::ostream& out);
+    }
+
+
+    namespace detail
+    {
+        // the name of T as printed by the compiler
+        template <typename T>
+        std::string stats_type_name()
+        {
+        #if defined(_MSC_VER)
+            std::string const name = __FUNCSIG__;
+            auto const begin = name.find("stats_type_name<") + 16;
+            auto const end = name.rfind(">(void)");
+        #else
+            std::string const name = __PRETTY_FUNCTION__;
+            auto const begin = name.find("T = ") + 4;
+            auto const end = name.find(';', begin) != std::string::npos ? name.find(';', begin) : name.rfind(']');
+        #endif
+            return name.substr(begin, end - begin);
+        }
+
+        inline std::uint64_t cycle_count()
+        {
+        #if not defined(NI_MATCH_INSTRUMENTATION_CYCLES)
+            return 0;
+        #elif defined(_MSC_VER) or defined(__x86_64__) or defined(__i386__)
+            return __rdtsc();
+        #else
+            return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+        #endif
+        }
+
+        // the counters are only written by their thread, a relaxed load & store is enough
+        inline void add_relaxed(std::atomic<std::uint64_t>& counter, std::uint64_t n)
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+
+        // The counters of a site are `calls, hits[num_cases], cycles[num_cases]`. Each thread has its own counters
+        // for each site, the registry merges them on demand.
+
+        class thread_match_counters;
+
+        class match_stats_registry
+        {
+        public:
+
+            static match_stats_registry& instance()
+            {
+                static match_stats_registry registry;
+                return registry;
+            }
+
+            std::size_t add_site(std::string name, std::vector<match_stats::case_stats> cases)
+            {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                m_sites.push_back({std::move(name), 0, 0, std::move(cases)});
+                m_retired.emplace_back(1 + 2 * m_sites.back().cases.size(), 0);
+                return m_sites.size() - 1;
+            }
+
+            void add_thread(thread_match_counters* counters)
+            {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                m_threads.push_back(counters);
+            }
+
+            void remove_thread(thread_match_counters* counters);
+
+            std::vector<match_stats::site_stats> snapshot();
+
+            void reset();
+
+        private:
+
+            std::mutex                                  m_mutex;
+            std::vector<match_stats::site_stats>        m_sites;
+            std::vector<std::vector<std::uint64_t>>     m_retired;
+            std::vector<thread_match_counters*>         m_threads;
+        };
+
+
+        class thread_match_counters
+        {
+        public:
+
+            static thread_match_counters& instance()
+            {
+                thread_local thread_match_counters counters;
+                return counters;
+            }
+
+            thread_match_counters(thread_match_counters const&) = delete;
+            thread_match_counters& operator=(thread_match_counters const&) = delete;
+
+            ~thread_match_counters()
+            {
+                match_stats_registry::instance().remove_thread(this);
+            }
+
+            //! The counters of the site for this thread, they stay valid until the thread exits
+            std::atomic<std::uint64_t>* counters(std::size_t site, std::size_t size)
+            {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                if (m_counters.size() <= site)
+                    m_counters.resize(site + 1);
+
+                auto& c = m_counters[site];
+                c.second = size;
+                c.first = std::make_unique<std::atomic<std::uint64_t>[]>(size);
+                for (std::size_t i = 0; i < size; ++i)
+                    c.first[i].store(0, std::memory_order_relaxed);
+                return c.first.get();
+            }
+
+            // adds the counters to `totals`, which has an entry for each site
+            void add_to(std::vector<std::vector<std::uint64_t>>& totals)
+            {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                for (std::size_t site = 0; site < m_counters.size(); ++site)
+                    for (std::size_t i = 0; i < m_counters[site].second; ++i)
+                        totals[site][i] += m_counters[site].first[i].load(std::memory_order_relaxed);
+            }
+
+            void reset()
+            {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                for (auto& c : m_counters)
+                    for (std::size_t i = 0; i < c.second; ++i)
+                        c.first[i].store(0, std::memory_order_relaxed);
+            }
+
+        private:
+
+            thread_match_counters()
+            {
+                match_stats_registry::instance().add_thread(this);
+            }
+
+            using counters_t = std::pair<std::unique_ptr<std::atomic<std::uint64_t>[]>, std::size_t>;
+
+            std::mutex               m_mutex;
+            std::vector<counters_t>  m_counters;
+        };
+
+
+        inline void match_stats_registry::remove_thread(thread_match_counters* counters)
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            counters->add_to(m_retired);
+            for (auto it = m_threads.begin(); it != m_threads.end(); ++it)
+                if (*it == counters)
+                {
+                    m_threads.erase(it);
+                    break;
+                }
+        }
+
+        inline std::vector<match_stats::site_stats> match_stats_registry::snapshot()
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+
+            auto totals = m_retired;
+            for (auto* counters : m_threads)
+                counters->add_to(totals);
+
+            auto sites = m_sites;
+            for (std::size_t s = 0; s < sites.size(); ++s)
+            {
+                auto& site = sites[s];
+                auto const num_cases = site.cases.size();
+                site.calls = totals[s][0];
+
+                std::uint64_t matched = 0;
+                for (std::size_t k = 0; k < num_cases; ++k)
+                {
+                    site.cases[k].hits = totals[s][1 + k];
+                    site.cases[k].cycles = totals[s][1 + num_cases + k];
+                    if (not site.cases[k].is_default)
+                        matched += site.cases[k].hits;
+                }
+                site.misses = site.calls > matched ? site.calls - matched : 0;
+            }
+            return sites;
+        }
+
+        inline void match_stats_registry::reset()
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            for (auto& retired : m_retired)
+                retired.assign(retired.size(), 0);
+            for (auto* counters : m_threads)
+                counters->reset();
+        }
+
+
+        // match_site<> is the site of a matcher with the given lambdas
+        template <typename... Lambdas>
+        struct match_site
+        {
+            static constexpr std::size_t num_cases = sizeof...(Lambdas);
+
+            static std::atomic<std::uint64_t>* counters()
+            {
+                static std::size_t const site = match_stats_registry::instance().add_site(name(), cases());
+                thread_local std::atomic<std::uint64_t>* const counters
+                    = thread_match_counters::instance().counters(site, 1 + 2 * num_cases);
+                return counters;
+            }
+
+            static void count_call()
+            {
+                add_relaxed(counters()[0], 1);
+            }
+
+            // counts a hit of case K and the cycles until it's destroyed
+            template <std::size_t K>
+            class case_scope
+            {
+            public:
+
+                case_scope() : m_counters{counters()}, m_start{cycle_count()}
+                {
+                    add_relaxed(m_counters[1 + K], 1);
+                }
+
+                case_scope(case_scope const&) = delete;
+                case_scope& operator=(case_scope const&) = delete;
+
+            #if defined(NI_MATCH_INSTRUMENTATION_CYCLES)
+                ~case_scope()
+                {
+                    add_relaxed(m_counters[1 + num_cases + K], cycle_count() - m_start);
+                }
+            #endif
+
+            private:
+
+                std::atomic<std::uint64_t>*  m_counters;
+                std::uint64_t                m_start;
+            };
+
+        private:
+
+            template <typename... Ts>
+            struct first_type;
+
+            template <typename T, typename... Ts>
+            struct first_type<T, Ts...> { using type = T; };
+
+            static std::string name()
+            {
+                return stats_type_name<typename first_type<Lambdas...>::type>();
+            }
+
+            static std::vector<match_stats::case_stats> cases()
+            {
+                std::vector<match_stats::case_stats> result
+                {   {   stats_type_name<signature_t<Lambdas>>()
+                    ,   0
+                    ,   0
+                    ,   signature<Lambdas>::number_of_arguments == 0
+                    }...
+                };
+                return result;
+            }
+        };
+
+
+        // counted_case<> invokes the lambda of case K of a site and counts it
+        template <typename Site, std::size_t K, typename Lambda, typename Signature = signature_t<Lambda>>
+        class counted_case;
+
+        template <typename Site, std::size_t K, typename Lambda, typename Result, typename... Args>
+        class counted_case<Site, K, Lambda, Result(Args...)>
+        {
+        public:
+
+            explicit counted_case(Lambda const& lambda) : m_lambda{lambda} {}
+
+            Result operator()(Args... args) const
+            {
+                typename Site::template case_scope<K> const scope;
+                return m_lambda(std::forward<Args>(args)...);
+            }
+
+        private:
+
+            Lambda  m_lambda;
+        };
+    }
+
+
+    namespace match_stats
+    {
+        inline std::vector<site_stats> snapshot()
+        {
+            return ::ni::detail::match_stats_registry::instance().snapshot();
+        }
+
+        inline void reset()
+        {
+            ::ni::detail::match_stats_registry::instance().reset();
+        }
+
+        inline void dump_text(std::ostream& out)
+        {
+            for (auto const& site : snapshot())
+            {
+                out << site.name << ": " << site.calls << " calls, " << site.misses << " misses\n";
+                for (auto const& c : site.cases)
+                {
+                    out << "    " << c.hits;
+                #if defined(NI_MATCH_INSTRUMENTATION_CYCLES)
+                    out << " (" << c.cycles << " cycles)";
+                #endif
+                    out << "  " << (c.is_default ? "default " : "") << c.signature << "\n";
+                }
+            }
+        }
+
+        inline void dump_json(std::ostream& out)
+        {
+            auto quoted = [&out](std::string const& s) -> std::ostream&
+            {
+                out << '"';
+                for (char c : s)
+                {
+                    if (c == '"' or c == '\\')
+                        out << '\\';
+                    out << c;
+                }
+                return out << '"';
+            };
+
+            auto const sites = snapshot();
+            out << "[";
+            for (std::size_t s = 0; s < sites.size(); ++s)
+            {
+                auto const& site = sites[s];
+                out << (s == 0 ? "" : ",") << "\n  {\"site\": ";
+                quoted(site.name) << ", \"calls\": " << site.calls << ", \"misses\": " << site.misses << ", \"cases\": [";
+                for (std::size_t k = 0; k < site.cases.size(); ++k)
+                {
+                    auto const& c = site.cases[k];
+                    out << (k == 0 ? "" : ", ") << "{\"signature\": ";
+                    quoted(c.signature) << ", \"hits\": " << c.hits << ", \"cycles\": " << c.cycles
+                                        << ", \"default\": " << (c.is_default ? "true" : "false") << "}";
+                }
+                out << "]}";
+            }
+            out << "\n]\n";
+        }
+    }
+
+}
@@ -9,11 +9,96 @@
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
 //
 // This is a customization point to ni::match for std::any and makes instances
-// of std::any matchable.
+// of std::any matchable. With at least 4 cases, the case is selected by reading
+// type() once: the last type seen by a thread is cached per list of cases, other
+// types are looked up in a hash table of the type_infos of the cases.
 //
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
 
+#pragma once
+
+#include <ni/meta/type_list.h>
+
 #include <any>
+#include <cstddef>
+#include <type_traits>
+#include <typeinfo>
+
+
+namespace ni
+{
+    namespace detail
+    {
+        // for fewer cases an any_cast per case is faster than the lookup
+        constexpr std::size_t min_cases_for_any_case_table = 4;
+
+        // maps the type of an any to the first case whose target is the same type
+        template <typename... Targets>
+        class any_case_table
+        {
+        public:
+
+            static constexpr std::size_t size = sizeof...(Targets);
+
+            static std::size_t lookup(std::type_info const& type)
+            {
+                thread_local cache_entry cache{nullptr, size};
+                if (cache.type == &type)
+                    return cache.index;
+
+                static const any_case_table table;
+                cache = {&type, table.find(type)};
+                return cache.index;
+            }
+
+        private:
+
+            struct cache_entry
+            {
+                std::type_info const* type;
+                std::size_t index;
+            };
+
+            static constexpr std::size_t num_buckets()
+            {
+                std::size_t n = 1;
+                while (n < 2 * size)
+                    n *= 2;
+                return n;
+            }
+
+            static constexpr std::size_t mask = num_buckets() - 1;
+
+            // open addressing, the buckets hold case indices, empty buckets hold size
+            any_case_table()
+            {
+                for (auto& b : m_buckets)
+                    b = size;
+
+                for (std::size_t k = 0; k < size; ++k)
+                {
+                    auto i = m_types[k]->hash_code() & mask;
+                    while (m_buckets[i] < size and not (*m_types[m_buckets[i]] == *m_types[k]))
+                        i = (i + 1) & mask;
+                    if (m_buckets[i] >= size)
+                        m_buckets[i] = k;
+                }
+            }
+
+            // compares with < instead of != size, so that the compiler can see the case indices are in range
+            std::size_t find(std::type_info const& type) const
+            {
+                for (auto i = type.hash_code() & mask; m_buckets[i] < size; i = (i + 1) & mask)
+                    if (*m_types[m_buckets[i]] == type)
+                        return m_buckets[i];
+                return size;
+            }
+
+            std::type_info const* const  m_types[size + 1] = { &typeid(Targets)..., nullptr };
+            std::size_t                  m_buckets[num_buckets()];
+        };
+    }
+}
 
 
 namespace std
@@ -29,4 +114,20 @@ namespace std
     {
         return any_cast<Target>(a);
     }
+
+    // the case of the type of the any, in O(1) instead of an any_cast per case
+    template <typename... Targets>
+    auto dyn_case(ni::meta::type_list<Targets...>, any const* a)
+    -> enable_if_t<sizeof...(Targets) >= ni::detail::min_cases_for_any_case_table, std::size_t>
+    {
+        return ni::detail::any_case_table<remove_cv_t<Targets>...>::lookup(a->type());
+    }
+
+    // any_cast only succeeds for the exact type, different types never match the same any
+    template <typename Target1, typename Target2>
+    auto dyn_disjoint(ni::meta::type_list<Target1, Target2>, any const*)
+    -> integral_constant<bool, not is_same<Target1, Target2>::value>
+    {
+        return {};
+    }
 }
@@ -0,0 +1,67 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+//
+// This is a customization point to ni::match for std::variant and makes instances
+// of std::variant matchable. The case is selected by a switch over index(), each
+// alternative calls the first case taking the alternative or one of its bases.
+// A match with a case for each alternative returns the result without optional,
+// on valueless variants it throws std::bad_variant_access.
+// The alternatives must be distinct types.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+#pragma once
+
+#include <ni/meta/fold_or.h>
+#include <ni/meta/type_list.h>
+
+#include <cstddef>
+#include <type_traits>
+#include <variant>
+
+
+namespace std
+{
+    // only for the alternatives, other targets are casted via the alternative of the index
+    template <typename Target, typename... Ts>
+    auto dyn_cast(variant<Ts...> const* v)
+    -> enable_if_t<ni::meta::fold_or_v<is_same<remove_cv_t<Target>, Ts>::value...>, Target const*>
+    {
+        return get_if<remove_cv_t<Target>>(v);
+    }
+
+    template <typename Target, typename... Ts>
+    auto dyn_cast(variant<Ts...>* v)
+    -> enable_if_t<ni::meta::fold_or_v<is_same<remove_cv_t<Target>, Ts>::value...>, Target*>
+    {
+        return get_if<remove_cv_t<Target>>(v);
+    }
+
+    // the alternatives are the types of the keys
+    template <typename... Ts>
+    ni::meta::type_list<Ts...> dyn_closed(variant<Ts...> const*)
+    {
+        return {};
+    }
+
+    // valueless variants return variant_npos, which matches no case
+    template <typename... Ts>
+    std::size_t dyn_key(variant<Ts...> const* v)
+    {
+        return v->index();
+    }
+
+    // exhaustive matches on valueless variants throw like std::visit
+    template <typename... Ts>
+    [[noreturn]] void dyn_key_out_of_range(variant<Ts...> const*)
+    {
+        throw bad_variant_access{};
+    }
+}
@@ -0,0 +1,39 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+
+//!---------------------------------------------------------------------------------------------------------------------
+//!  \file
+//!
+//!  `type_list` is a meta template container of types. Its used for meta-programming algorithms and to pass lists
+//!  of types to customization points.
+//!
+//!---------------------------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+
+namespace ni {
+
+    namespace meta {
+
+        template <typename... Ts>
+        struct type_list
+        {
+            static constexpr std::size_t size = sizeof...(Ts);
+        };
+
+        template <typename... Ts>
+        constexpr std::size_t type_list<Ts...>::size;
+
+    }
+
+}
@@ -19,7 +19,9 @@
 //!
 //!  The framework provides a mechanism to inherit types from others to build the actual library and provides tools
 //!  to test for convertibility and casting. It is also well integrated into `ni::match` which is meant to be the
-//!  main use case. It does not provide any mechanism to have some sort of function overload.
+//!  main use case. Functions that are overloaded on the dynamic type can be added as open methods via
+//!  `ni::type_hierarchy::method` (see type_hierarchy/method.h). Matchers with many cases select the case through a
+//!  table lookup on the id instead of trying each case (see `dyn_case`).
 //!
 //!  Example usage scenario:
 //!  ```
@@ -48,6 +50,84 @@
 //!                                                                              // on level 2, 63 types on the level 3
 //!  ```
 //!
+//!  If the number of types on each level is known, `from_shape` picks the minimal number of bits for each level.
+//!  Small ids keep the objects small and the tables for `dyn_case` or `method` dense. With dynamic ids the count
+//!  is the number of types on the level over all branches, with static ids the largest local id of the level.
+//!  ```
+//!  using Event = ni::type_hierarchy::from_shape<Base, 5, 20, 3>;   // from_base<Base, 3, 5, 2>, 2 byte ids
+//!  ```
+//!
+//!  If the bits of all levels add up to more than 64, the ids are `wide_id`s of a multiple of 128 bits and
+//!  `convertible_to` compares them with SSE2 or AVX2 instructions (see type_hierarchy/wide_id.h). Wide static ids
+//!  are constant expressions as well, but they can't be used as `case` labels.
+//!
+//!  By default the ids are assigned at static initialization time. Alternatively the client can provide the id of
+//!  a type on its level explicitly via `static_id<N>`. These ids are compile time constants, they don't need any
+//!  initializer at startup and can be used in constant expressions via `id_v<T>`, e.g. in `switch` statements:
+//!  ```
+//!  using Root = ni::type_hierarchy::from_base<UserDefinedBase>;
+//!  struct Child1 : ni::sub_type<Child1, Root, ni::type_hierarchy::static_id<1>> {...};
+//!  struct Child2 : ni::sub_type<Child2, Root, ni::type_hierarchy::static_id<2>> {...};
+//!  struct GrandChild1 : ni::sub_type<GrandChild1, Child1, ni::type_hierarchy::static_id<1>> {...};
+//!
+//!  switch (r.type_hierarchy_id__())
+//!  {
+//!      case ni::type_hierarchy::id_v<Child1>: ...
+//!      case ni::type_hierarchy::id_v<GrandChild1>: ...
+//!  }
+//!  ```
+//!  Static ids must be unique on each level of a branch, which debug builds check at startup, and can only be used
+//!  below types with static ids. Static and dynamic ids must not be mixed on the same level of a hierarchy.
+//!
+//!  Dynamic ids depend on the order of static initialization and may differ between processes or between a host and
+//!  its plugins. `hashed_id<>` derives the id from a hash of the type's name instead, so it's the same in every build
+//!  and binary and can be stored in files or shared memory. Debug builds detect collisions at startup, which can be
+//!  resolved by passing a salt, e.g. `hashed_id<1>`. Release builds don't check, colliding types silently share an
+//!  id, so hashed types must be run in a debug build once they are added. Since the names are taken from the compiler,
+//!  types in anonymous namespaces may get different ids with different compilers, use `static_id<N>` for explicit ids
+//!  instead.
+//!  ```
+//!  struct Child1 : ni::sub_type<Child1, Root, ni::type_hierarchy::hashed_id<>> {...};
+//!  ```
+//!  Hashes are spread over all ids of the level, i.e. levels with only a few bits collide quickly.
+//!
+//!  Types can be defined in plugins. Dynamic ids are assigned thread-safe, so plugins can be loaded concurrently,
+//!  and the ids of a plugin's types are released and reused when it's unloaded. The plugin must not be unloaded
+//!  while objects of its types exist. Reading ids, `convertible_to` and `match` never synchronize, the ids are
+//!  constants once assigned. Ids are only released if the types are instantiated in the plugin and not in the host.
+//!
+//!  Besides the tree of types the client can declare interfaces, i.e. base classes that any type of the hierarchy
+//!  may implement in addition to its super type. `ni::convertible_to<Interface>` and `ni::match` cases taking an
+//!  interface test a bitset stored in each object next to its id, there's no `dynamic_cast` involved. Interfaces
+//!  must be non-virtual base classes, at most 64 can be declared per hierarchy.
+//!  ```
+//!  struct UserDefinedBase
+//!  {
+//!      using type_hierarchy_interfaces = ni::meta::type_list<Undoable, Serializable>;
+//!  };
+//!  using Root = ni::type_hierarchy::from_base<UserDefinedBase>;
+//!  struct Child1 : ni::sub_type<Child1, Root>, Undoable {...};
+//!
+//!  ni::match(r)
+//!  (   [](Undoable& u) { u.undo(); }
+//!  ,   [] {}
+//!  );
+//!  ```
+//!
+//!  A hierarchy whose types are fixed can be declared closed by listing all types objects can have. `ni::match`
+//!  then knows which matches are exhaustive, i.e. have a case for each of the types. Those return the result of the
+//!  case instead of an optional, and the branch for objects that don't match any case is compiled away. Matches that
+//!  are meant to be exhaustive can be checked by their result type. The declaration is found by ADL and doesn't need
+//!  a definition.
+//!  ```
+//!  ni::type_hierarchy::closed<Root, Child1, Child2, GrandChild1> type_hierarchy_closed(Root const*);
+//!
+//!  int n = ni::match(r)
+//!  (   [](Child1 const&) { return 1; }        // also matches GrandChild1
+//!  ,   [](Child2 const&) { return 2; }
+//!  );
+//!  ```
+//!
 //!  In order to prevent copy-paste errors (due to the CRTP-redundancy) it is advisable to use the macro
 //!  `NI_SUB_TYPE` to derive types. Example:
 //!  ```
@@ -56,11 +136,12 @@
 //!   NI_SUB_TYPE( struct Child1, Root ) {...};
 //!   // instead of
 //!   struct Child1 : ni::sub_type<Child1, Root> {...};
+//!   // the id policy can be passed as optional 3rd argument
+//!   struct NI_SUB_TYPE( Child2, Root, ni::type_hierarchy::static_id<2> ) {...};
 //!  ```
 //!
 //!
 //!  TODO (nice to haves)
-//!  • test dyn_cast from/to several levels w/ & w/o const
 //!  • test with actual storage
 //!  • assert that derived class is arg in id_holder (i.e. assert that the 1st arg of sub_type is always the deriver)
 //!
@@ -70,12 +151,18 @@
 
 #include <ni/meta/scan_add.h>
 #include <ni/meta/fold_add.h>
+#include <ni/meta/fold_and.h>
+#include <ni/meta/type_list.h>
+#include <ni/type_hierarchy/wide_id.h>
 
 #include <boost/assert.hpp>
 #include <cstdint>
 #include <cstddef>
+#include <limits>
+#include <mutex>
 #include <utility>
 #include <type_traits>
+#include <vector>
 
 namespace ni {
 
@@ -85,6 +172,8 @@ namespace type_hierarchy_detail {
     // 1. a system to tag and identify the inheritance level
     // 2. a system of types that get interleaved into the hierarchy to manage the types' identity
     // 3. a system to assign unique IDs to each type and test for castability.
+    // An optional 4th part registers the types at runtime for introspection.
+    // Interfaces the client declared for the hierarchy are tracked alongside the ids (see Interfaces).
 
 
     //------------------------------------------------------------------------------------------------------------------
@@ -134,6 +223,24 @@ namespace type_hierarchy_detail {
     template <typename Config>
     struct config_holder {};
 
+
+    // registration<> adds types to the registry of their hierarchy if the client enabled it (see 4.)
+    template <typename T>
+    struct to_void { using type = void; };
+
+    template <typename BaseType, typename = void>
+    struct registry_enabled : std::false_type {};
+
+    template <typename BaseType>
+    struct registry_enabled<BaseType, typename to_void<typename BaseType::type_hierarchy_registry>::type> : std::true_type {};
+
+    template < typename Config, typename Derived, typename SuperType
+             , bool Enabled = registry_enabled<typename Config::base_type>::value >
+    struct registration
+    {
+        static void touch() {}
+    };
+
     template <typename T>
     struct get_config
     {
@@ -149,10 +256,48 @@ namespace type_hierarchy_detail {
     template <typename T>
     using get_config_t = typename get_config<T>::type;
 
+
+    // interface_holder<> stores the interfaces an object implements if the client declared any (see Interfaces)
+    template <typename BaseType, typename = void>
+    struct declared_interfaces
+    {
+        using type = meta::type_list<>;
+    };
+
+    template <typename BaseType>
+    struct declared_interfaces<BaseType, typename to_void<typename BaseType::type_hierarchy_interfaces>::type>
+    {
+        using type = typename BaseType::type_hierarchy_interfaces;
+    };
+
+    template <typename Config, bool Enabled = (Config::interfaces::size > 0)>
+    struct interface_holder
+    {
+    protected:
+        template <typename Derived, typename IdHolder>
+        void assign_type_hierarchy_interfaces__(IdHolder*) {}
+    };
+
+
+    // id policies select how the id of a type is assigned (see 3.)
+    struct dynamic_id {};
+
+    template <std::uint64_t LocalId>
+    struct static_id {};
+
+    template <std::uint64_t Salt = 0>
+    struct hashed_id {};
+
+    template <typename Config, typename Derived, typename SuperType, typename IdPolicy>
+    struct id_value;
+
+    template <typename T>
+    struct id_of;
+
     // base type inherits from user defined root
     // holds the id which is used by the system to identify each type at runtime
     template <typename Config>
-    struct id_holder<Config> : Config::base_type, level_tag<0>, config_holder<Config>
+    struct id_holder<Config> : Config::base_type, level_tag<0>, config_holder<Config>, interface_holder<Config>
     {
     private:
         typename Config::id_t  m_type_hierarchy_id__;
@@ -166,49 +311,167 @@ namespace type_hierarchy_detail {
 
 
     // each derived type gets its own id by putting this type in between base and derived
-    template <typename Config, typename Derived>
-    struct id_holder<Config, Derived, void> : id_holder<Config>, level_tag<1>
+    template <typename Config, typename Derived, typename IdPolicy>
+    struct id_holder<Config, Derived, void, IdPolicy> : id_holder<Config>, level_tag<1>
     {
     private:
-        static const typename Config::id_t  s_type_hierarchy__;
-        static typename Config::id_t type_hierarchy_init_id__();
+        using type_hierarchy_id_value__ = id_value<Config, Derived, void, IdPolicy>;
         template <typename, typename...>
         friend struct id_holder;
-        template <typename, typename, typename>
-        friend struct convertible_to_impl;
+        template <typename, typename, typename, typename>
+        friend struct id_value;
+        template <typename>
+        friend struct id_of;
     public:
         id_holder()
         {
-            id_holder::m_type_hierarchy_id__ = s_type_hierarchy__;
+            registration<Config, Derived, void>::touch();
+            type_hierarchy_id_value__::touch();
+            id_holder::m_type_hierarchy_id__ = type_hierarchy_id_value__::value;
+            this->template assign_type_hierarchy_interfaces__<Derived>(this);
         }
     };
 
     // all deeper derivatives derive from some SuperType that has to derive from a type<N,...>
-    template <typename Config, typename Derived, typename SuperType>
-    struct id_holder<Config, Derived, SuperType> : SuperType, level_tag<level_of_v<SuperType>+1>
+    template <typename Config, typename Derived, typename SuperType, typename IdPolicy>
+    struct id_holder<Config, Derived, SuperType, IdPolicy> : SuperType, level_tag<level_of_v<SuperType>+1>
     {
     private:
         static_assert( level_of_v<SuperType> < typename Config::bits_per_level{}.size()
                      , "Supported number of hierarchy levels exceeded."
                      );
-        static const typename Config::id_t  s_type_hierarchy__;
-        static typename Config::id_t type_hierarchy_init_id__();
+        using type_hierarchy_id_value__ = id_value<Config, Derived, SuperType, IdPolicy>;
         template <typename, typename... >
         friend struct id_holder;
-        template <typename, typename, typename>
-        friend struct convertible_to_impl;
+        template <typename, typename, typename, typename>
+        friend struct id_value;
+        template <typename>
+        friend struct id_of;
     public:
-        using super_t = id_holder<Config, Derived, SuperType>;
+        using super_t = id_holder<Config, Derived, SuperType, IdPolicy>;
 
         template <typename... Args>
         id_holder(Args&&... args) : SuperType{std::forward<Args>(args)...}
         {
-            SuperType::m_type_hierarchy_id__ = s_type_hierarchy__;
+            registration<Config, Derived, SuperType>::touch();
+            type_hierarchy_id_value__::touch();
+            SuperType::m_type_hierarchy_id__ = type_hierarchy_id_value__::value;
+            this->template assign_type_hierarchy_interfaces__<Derived>(this);
         }
     };
 
 
 
+    //------------------------------------------------------------------------------------------------------------------
+    // Interfaces
+    //------------------------------------------------------------------------------------------------------------------
+
+    // The client may declare interfaces, i.e. additional base classes of the types of the hierarchy, in the user
+    // defined base via `using type_hierarchy_interfaces = ni::meta::type_list<Interface1, Interface2>;`. Each
+    // interface gets a bit, and each object stores the bits of the interfaces its type implements next to its id.
+    // Testing for an interface is a single AND. The cast to the interface calls a function of the object's type that
+    // is stored next to the bits, since the address of the interface depends on the layout of the type.
+
+    template <typename T, typename... Interfaces>
+    constexpr std::size_t interface_index(meta::type_list<Interfaces...>)
+    {
+        constexpr bool same[] = { false, std::is_same<T, Interfaces>::value... };
+        for (std::size_t i = 0; i < sizeof...(Interfaces); ++i)
+            if (same[i+1])
+                return i;
+        return sizeof...(Interfaces);
+    }
+
+    template <typename Config, typename T>
+    struct is_interface_of : std::integral_constant< bool
+    ,   interface_index<T>(typename Config::interfaces{}) < Config::interfaces::size
+    > {};
+
+    template <typename T>
+    struct is_interface_of<void, T> : std::false_type {};
+
+    template <typename Config>
+    using interface_bits_t = std::conditional_t<(Config::interfaces::size <= 32), std::uint32_t, std::uint64_t>;
+
+    template <typename Config, typename Interface>
+    constexpr interface_bits_t<Config> interface_bit_v
+        = interface_bits_t<Config>(1) << interface_index<Interface>(typename Config::interfaces{});
+
+    template <typename Config, typename T, typename... Interfaces>
+    constexpr interface_bits_t<Config> interface_bits(meta::type_list<Interfaces...>)
+    {
+        constexpr bool implements[] = { false, std::is_base_of<Interfaces, T>::value... };
+        interface_bits_t<Config> bits = 0;
+        for (std::size_t i = 0; i < sizeof...(Interfaces); ++i)
+            if (implements[i+1])
+                bits |= interface_bits_t<Config>(1) << i;
+        return bits;
+    }
+
+    template <typename Interface, typename T>
+    void* interface_address(T* p, std::true_type /* implements */)
+    {
+        return static_cast<Interface*>(p);
+    }
+
+    template <typename Interface, typename T>
+    void* interface_address(T*, std::false_type)
+    {
+        return nullptr;
+    }
+
+    // casts the root of an object of type T to the interface with the given index, only valid after construction
+    template <typename Config, typename T, typename... Interfaces>
+    void* interface_cast_for(id_holder<Config>* root, std::size_t index, meta::type_list<Interfaces...>)
+    {
+        auto* p = static_cast<T*>(root);
+        void* const addresses[] = { interface_address<Interfaces>(p, std::is_base_of<Interfaces, T>{})... };
+        return addresses[index];
+    }
+
+    template <typename Config, typename T>
+    void* interface_cast_of(id_holder<Config>* root, std::size_t index)
+    {
+        return interface_cast_for<Config, T>(root, index, typename Config::interfaces{});
+    }
+
+    template <typename Config>
+    struct interface_holder<Config, true>
+    {
+        static_assert( Config::interfaces::size <= 64, "At most 64 interfaces are supported." );
+
+    private:
+        void*                       (*m_type_hierarchy_interface_cast__)(id_holder<Config>*, std::size_t) = nullptr;
+        interface_bits_t<Config>    m_type_hierarchy_interfaces__ = 0;
+
+    protected:
+        template <typename Derived, typename IdHolder>
+        void assign_type_hierarchy_interfaces__(IdHolder*)
+        {
+            m_type_hierarchy_interface_cast__ = &interface_cast_of<Config, Derived>;
+            m_type_hierarchy_interfaces__ = interface_bits<Config, Derived>(typename Config::interfaces{});
+        }
+
+    public:
+        //! The bits of the interfaces the object implements
+        interface_bits_t<Config> type_hierarchy_interfaces__() const { return m_type_hierarchy_interfaces__; }
+
+        //! The address of the interface of the object, only valid if the object implements it
+        template <typename Interface>
+        void* type_hierarchy_interface_cast__(id_holder<Config>* root) const
+        {
+            return m_type_hierarchy_interface_cast__(root, interface_index<Interface>(typename Config::interfaces{}));
+        }
+    };
+
+    template <typename Interface, typename Config>
+    bool implements(interface_holder<Config, true> const& x)
+    {
+        return (x.type_hierarchy_interfaces__() & interface_bit_v<Config, Interface>) != 0;
+    }
+
+
+
     //------------------------------------------------------------------------------------------------------------------
     // 3. Static Type IDs
     //------------------------------------------------------------------------------------------------------------------
@@ -225,30 +488,367 @@ namespace type_hierarchy_detail {
     constexpr int lookup_v = get<N>(typename Config::level_shifts{});
 
     template <typename Config, typename T>
-    constexpr typename Config::id_t shift_v = lookup_v<Config, level_of_v<T>>;
+    constexpr int shift_v = lookup_v<Config, level_of_v<T>>;
+
+    // mask of the lowest `num_bits` bits, also valid if `num_bits` covers the whole id
+    template <typename Id>
+    constexpr Id low_bits(int num_bits)
+    {
+        return num_bits < int(sizeof(Id) * 8)
+            ?  static_cast<Id>((static_cast<Id>(1) << num_bits) - 1)
+            :  static_cast<Id>(~static_cast<Id>(0));
+    }
 
     template <typename Config, typename T>
-    constexpr typename Config::id_t mask_v = (1 << shift_v<Config, T>) - 1;
+    constexpr typename Config::id_t mask_v = low_bits<typename Config::id_t>(shift_v<Config, T>);
+
+    // the largest local id of the level, without shifting by the full width for levels of 64 bits
+    template <typename Config, int Level>
+    constexpr std::uint64_t max_local_id_v = low_bits<std::uint64_t>(get<Level>(typename Config::bits_per_level{}));
+
+
+
+    // id_allocator<> generates the local ids which are used to tag each type on each level. Ids that are released,
+    // because the binary that defined the type has been unloaded, are reused before new ones are generated.
+    template <typename Config, int Level>
+    class id_allocator
+    {
+    public:
+
+        using id_t = typename Config::id_t;
+
+        static id_allocator& instance()
+        {
+            static id_allocator allocator;
+            return allocator;
+        }
+
+        id_t acquire()
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            if (not m_released.empty())
+            {
+                auto const id = m_released.back();
+                m_released.pop_back();
+                return id;
+            }
+            BOOST_ASSERT_MSG( (m_next <= max_local_id_v<Config, Level>)
+                            , "Ids for level are exhausted."
+                            );
+            return static_cast<id_t>(m_next++);
+        }
+
+        void release(id_t id)
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_released.push_back(id);
+        }
+
+    private:
+
+        std::mutex         m_mutex;
+        std::uint64_t      m_next = 1;
+        std::vector<id_t>  m_released;
+    };
+
+    // id_lease<> owns a local id while the binary that contains the lease is loaded
+    template <typename Config, int Level>
+    struct id_lease
+    {
+        id_lease() : local_id{id_allocator<Config, Level>::instance().acquire()} {}
+        ~id_lease() { id_allocator<Config, Level>::instance().release(local_id); }
+
+        id_lease(id_lease const&) = delete;
+        id_lease& operator=(id_lease const&) = delete;
+
+        typename Config::id_t const local_id;
+    };
+
+
+    // id_value<> computes the id of a type depending on the chosen policy:
+    //
+    // • dynamic_id:  ids are assigned during static initialization by id_allocator<>. They depend on the initialization
+    //                order and need a guarded initializer per type. The id is released when the binary that
+    //                contains the initializer is unloaded.
+    // • static_id<N>: the client provides the local id N of the type on its level (1 <= N < 2^bits of the level),
+    //                the id is a compile time constant. N must be unique among the static ids on that level of the
+    //                branch, debug builds check this during static initialization. Static ids can only be used if all
+    //                super types have static ids as well. Static and dynamic ids must not be mixed on the same level
+    //                of a hierarchy, since dynamic ids do not know about the static ones.
+    // • hashed_id<S>: the local id is a hash of the name of the type and the salt S. The id is a compile time constant
+    //                and independent of the build and the binary. Debug builds check for collisions of the hashes
+    //                during static initialization, release builds don't. A collision can be resolved by changing the
+    //                salt of one type.
+    //                Like static ids hashed ids require super types with static or hashed ids.
+
+    template <typename SuperType>
+    struct super_id_value
+    {
+        using type = id_of<SuperType>;
+    };
+
+    template <>
+    struct super_id_value<void>
+    {
+        struct type
+        {
+            static constexpr bool is_static = true;
+            static constexpr int init() { return 0; }
+        };
+    };
+
+    template <typename Config, typename Derived, typename SuperType>
+    struct id_value<Config, Derived, SuperType, dynamic_id>
+    {
+        static constexpr bool is_static = false;
+        static const typename Config::id_t value;
+
+        static void touch() {}
+
+        static typename Config::id_t init()
+        {
+            constexpr auto shift = shift_v<Config, SuperType>;
+            static const id_lease<Config, level_of_v<SuperType>> lease;
+            static const typename Config::id_t id = static_cast<typename Config::id_t>(
+                super_id_value<SuperType>::type::init() | (lease.local_id << shift)
+            );
+            return id;
+        }
+    };
+
+    template <typename Config, typename Derived, typename SuperType>
+    const typename Config::id_t id_value<Config, Derived, SuperType, dynamic_id>::value = init();
+
+
+    template <typename Config>
+    class static_ids;
+
+    template <typename Config, typename Derived, typename SuperType, std::uint64_t LocalId>
+    struct id_value<Config, Derived, SuperType, static_id<LocalId>>
+    {
+        static_assert( super_id_value<SuperType>::type::is_static
+                     , "Static ids require all super types to have static ids."
+                     );
+        static_assert( 0 < LocalId, "Static ids must be greater than zero." );
+        static_assert( LocalId <= max_local_id_v<Config, level_of_v<SuperType>>, "Ids for level are exhausted." );
+
+        static constexpr bool is_static = true;
+        static constexpr typename Config::id_t value = static_cast<typename Config::id_t>(
+            super_id_value<SuperType>::type::init() | (static_cast<typename Config::id_t>(LocalId) << shift_v<Config, SuperType>)
+        );
+
+        static constexpr typename Config::id_t init() { return value; }
+
+    #if defined(NDEBUG)
+        static void touch() {}
+    #else
+        static const typename static_ids<Config>::entry checked;
+
+        static void touch()
+        {
+            static_cast<void>(&checked);
+        }
+    #endif
+    };
+
+    template <typename Config, typename Derived, typename SuperType, std::uint64_t LocalId>
+    constexpr typename Config::id_t id_value<Config, Derived, SuperType, static_id<LocalId>>::value;
+
+
+    // the name of T as written by the compiler, e.g. `ns::Type`
+    struct type_name_t
+    {
+        char const*  data;
+        std::size_t  size;
+    };
+
+    constexpr std::size_t find_string(char const* s, char const* pattern, std::size_t from = 0)
+    {
+        for (std::size_t i = from; s[i] != 0; ++i)
+        {
+            std::size_t n = 0;
+            while (pattern[n] != 0 and s[i + n] == pattern[n])
+                ++n;
+            if (pattern[n] == 0)
+                return i;
+        }
+        return std::size_t(-1);
+    }
+
+    constexpr bool starts_with(type_name_t name, char const* prefix)
+    {
+        std::size_t n = 0;
+        while (prefix[n] != 0 and n < name.size and name.data[n] == prefix[n])
+            ++n;
+        return prefix[n] == 0;
+    }
+
+    constexpr type_name_t strip_prefix(type_name_t name, char const* prefix, std::size_t prefix_size)
+    {
+        return starts_with(name, prefix) ? type_name_t{name.data + prefix_size, name.size - prefix_size} : name;
+    }
 
+    template <typename T>
+    constexpr type_name_t type_name()
+    {
+    #if defined(_MSC_VER)
+        char const* s = __FUNCSIG__;
+        std::size_t const begin = find_string(s, "type_name<") + 10;
+        std::size_t const end = find_string(s, ">(void)", begin);
+    #else
+        char const* s = __PRETTY_FUNCTION__;
+        std::size_t const begin = find_string(s, "T = ") + 4;
+        std::size_t end = begin;
+        while (s[end] != ';' and s[end] != ']')
+            ++end;
+    #endif
+        return strip_prefix(strip_prefix(type_name_t{s + begin, end - begin}, "struct ", 7), "class ", 6);
+    }
 
+    constexpr bool operator==(type_name_t a, type_name_t b)
+    {
+        if (a.size != b.size)
+            return false;
+        for (std::size_t i = 0; i < a.size; ++i)
+            if (a.data[i] != b.data[i])
+                return false;
+        return true;
+    }
 
-    // next_id() generates the id which is used to tag each type on each level
-    template <typename Config, int Level=0>
-    typename Config::id_t next_id()
+    // FNV-1a
+    constexpr std::uint64_t hash_name(type_name_t name, std::uint64_t salt)
     {
-        static typename Config::id_t id{};
-        ++id;
-        BOOST_ASSERT_MSG( id < (static_cast<typename Config::id_t>(1) << get<Level>(typename Config::bits_per_level{}))
-                        , "Ids for level are exhausted."
-                        );
-        return id;
+        std::uint64_t h = 14695981039346656037ull ^ salt;
+        for (std::size_t i = 0; i < name.size; ++i)
+            h = (h ^ static_cast<unsigned char>(name.data[i])) * 1099511628211ull;
+        return h;
     }
 
 
+    // static and hashed ids of a hierarchy that have been used, to detect duplicates in debug builds. Entries remove
+    // themselves when the binary that contains them is unloaded.
+    template <typename Config>
+    class static_ids
+    {
+    public:
+
+        struct entry
+        {
+            entry(typename Config::id_t id_, type_name_t name_) : id{id_}, name{name_} { instance().add(*this); }
+            ~entry() { instance().remove(*this); }
+
+            entry(entry const&) = delete;
+            entry& operator=(entry const&) = delete;
+
+            typename Config::id_t  id;
+            type_name_t            name;
+            entry*                 next = nullptr;
+        };
+
+    private:
+
+        static static_ids& instance()
+        {
+            static static_ids ids;
+            return ids;
+        }
+
+        void add(entry& e)
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            for (auto const* other = m_head; other; other = other->next)
+                BOOST_ASSERT_MSG( other->id != e.id or other->name == e.name
+                                , "Types have the same id, change the static id or the salt of one of them."
+                                );
+            e.next = m_head;
+            m_head = &e;
+        }
+
+        void remove(entry& e)
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            for (auto** p = &m_head; *p; p = &(*p)->next)
+                if (*p == &e)
+                {
+                    *p = e.next;
+                    break;
+                }
+        }
+
+        std::mutex  m_mutex;
+        entry*      m_head = nullptr;
+    };
+
+    template <typename Config, typename Derived, typename SuperType, std::uint64_t Salt>
+    struct id_value<Config, Derived, SuperType, hashed_id<Salt>>
+    {
+        static_assert( super_id_value<SuperType>::type::is_static
+                     , "Hashed ids require all super types to have static or hashed ids."
+                     );
+
+        static constexpr std::uint64_t local_id
+            = hash_name(type_name<Derived>(), Salt) % max_local_id_v<Config, level_of_v<SuperType>> + 1;
+
+        static constexpr bool is_static = true;
+        static constexpr typename Config::id_t value = static_cast<typename Config::id_t>(
+            super_id_value<SuperType>::type::init() | (static_cast<typename Config::id_t>(local_id) << shift_v<Config, SuperType>)
+        );
+
+        static constexpr typename Config::id_t init() { return value; }
+
+    #if defined(NDEBUG)
+        static void touch() {}
+    #else
+        static const typename static_ids<Config>::entry checked;
+
+        static void touch()
+        {
+            static_cast<void>(&checked);
+        }
+    #endif
+    };
+
+    template <typename Config, typename Derived, typename SuperType, std::uint64_t Salt>
+    constexpr typename Config::id_t id_value<Config, Derived, SuperType, hashed_id<Salt>>::value;
+
+#if not defined(NDEBUG)
+    template <typename Config, typename Derived, typename SuperType, std::uint64_t LocalId>
+    const typename static_ids<Config>::entry id_value<Config, Derived, SuperType, static_id<LocalId>>::checked
+        { value, type_name<Derived>() };
+
+    template <typename Config, typename Derived, typename SuperType, std::uint64_t Salt>
+    const typename static_ids<Config>::entry id_value<Config, Derived, SuperType, hashed_id<Salt>>::checked
+        { value, type_name<Derived>() };
+#endif
+
+
+    // id_of<> gives access to the id of a type of the hierarchy. The root has the id 0.
+    template <typename T>
+    struct id_of : T::type_hierarchy_id_value__ {};
+
+    template <typename Config>
+    struct id_of<id_holder<Config>>
+    {
+        static constexpr bool is_static = true;
+        static constexpr typename Config::id_t value = 0;
+        static constexpr typename Config::id_t init() { return value; }
+    };
+
+    template <typename Config>
+    constexpr typename Config::id_t id_of<id_holder<Config>>::value;
+
+    template <typename T>
+    struct static_id_of : id_of<std::remove_cv_t<T>>
+    {
+        static_assert( id_of<std::remove_cv_t<T>>::is_static, "Type does not have a static id." );
+    };
+
+
+    // convertible_to_impl<> tests if an object with the given id is convertible to TargetType
     template <typename TargetType, typename TargetConfig, typename SourceConfig>
     struct convertible_to_impl
     {
-        static bool apply(id_holder<SourceConfig> const&)
+        static bool apply(typename SourceConfig::id_t)
         {
             return false;
         }
@@ -257,89 +857,392 @@ namespace type_hierarchy_detail {
     template <typename TargetType, typename Config>
     struct convertible_to_impl<TargetType, Config, Config>
     {
-        static bool apply(id_holder<Config> const& src)
+        static bool apply(typename Config::id_t id)
         {
-            return (mask_v<Config, TargetType> & src.type_hierarchy_id__()) == TargetType::s_type_hierarchy__;
+            return equal_under_mask(id, mask_v<Config, TargetType>, id_of<std::remove_cv_t<TargetType>>::value);
         }
     };
 
     template <typename Config>
     struct convertible_to_impl<typename Config::base_type, void, Config>
     {
-        static bool apply(id_holder<Config> const&)
+        static bool apply(typename Config::id_t)
         {
             return true;
         }
     };
 
+    template <typename TargetType, typename Config>
+    bool convertible_to_object(std::false_type /* is interface */, id_holder<Config> const& x)
+    {
+        return convertible_to_impl<TargetType, get_config_t<TargetType>, Config>::apply(x.type_hierarchy_id__());
+    }
+
+    template <typename TargetType, typename Config>
+    bool convertible_to_object(std::true_type, id_holder<Config> const& x)
+    {
+        return implements<std::remove_cv_t<TargetType>>(x);
+    }
+
     template <typename TargetType, typename SourceType,
         typename = std::enable_if_t<std::is_base_of<level_tag<0>, SourceType>::value> >
     bool convertible_to(SourceType const& x)
     {
         using config_t = get_config_t<SourceType>;
         auto const& src = static_cast<id_holder<config_t> const&>(x);
-        return convertible_to_impl<TargetType, get_config_t<TargetType>, config_t>::apply(src);
+        return convertible_to_object<TargetType>(is_interface_of<config_t, std::remove_cv_t<TargetType>>{}, src);
     }
 
 
-    template <typename Config, typename Derived>
-    typename Config::id_t id_holder<Config, Derived, void>::type_hierarchy_init_id__()
+    //------------------------------------------------------------------------------------------------------------------
+    // Casting
+    //------------------------------------------------------------------------------------------------------------------
+
+    // dyn_cast<> casts from any level to any level of the hierarchy. Up-casts always succeed and casts between types
+    // that are not on the same path of the tree (e.g. siblings) always fail without looking at the id. Casts to
+    // declared interfaces test the interface bits of the object. The constness of the source is propagated to the
+    // target.
+
+    template <typename TargetType, typename SourceType>
+    using cast_result_t = std::conditional_t<std::is_const<SourceType>::value, TargetType const, TargetType>*;
+
+    struct up_cast {};
+    struct down_cast {};
+    struct cross_cast {};
+    struct interface_cast {};
+
+    template <typename TargetType, typename SourceType>
+    using cast_kind_t = std::conditional_t
+    <   std::is_base_of<std::remove_cv_t<TargetType>, SourceType>::value
+    ,   up_cast
+    ,   std::conditional_t
+        <   std::is_base_of<SourceType, std::remove_cv_t<TargetType>>::value
+        ,   down_cast
+        ,   std::conditional_t
+            <   is_interface_of<get_config_t<SourceType>, std::remove_cv_t<TargetType>>::value
+            ,   interface_cast
+            ,   cross_cast
+            >
+        >
+    >;
+
+    template <typename TargetType, typename SourceType>
+    cast_result_t<TargetType, SourceType> dyn_cast_impl(up_cast, SourceType* p)
     {
-        static const typename Config::id_t id = next_id<Config, 0>();
-        return id;
+        return p;
     }
 
-    template <typename Config, typename Derived>
-    const typename Config::id_t id_holder<Config, Derived, void>::s_type_hierarchy__ = type_hierarchy_init_id__();
+    template <typename TargetType, typename SourceType>
+    cast_result_t<TargetType, SourceType> dyn_cast_impl(down_cast, SourceType* p)
+    {
+        return convertible_to<TargetType>(*p) ? static_cast<cast_result_t<TargetType, SourceType>>(p) : nullptr;
+    }
 
-    template <typename Config, typename Derived, typename SuperType>
-    typename Config::id_t id_holder<Config, Derived, SuperType>::type_hierarchy_init_id__()
+    template <typename TargetType, typename SourceType>
+    cast_result_t<TargetType, SourceType> dyn_cast_impl(cross_cast, SourceType*)
     {
-        constexpr auto shift = shift_v<Config, SuperType>;
-        static const typename Config::id_t id =
-            SuperType::type_hierarchy_init_id__() | (next_id<Config, level_of_v<SuperType>>() << shift);
-        return id;
+        return nullptr;
     }
 
+    template <typename TargetType, typename SourceType>
+    cast_result_t<TargetType, SourceType> dyn_cast_impl(interface_cast, SourceType* p)
+    {
+        using interface_t = std::remove_cv_t<TargetType>;
+        using root_t = id_holder<get_config_t<SourceType>>;
 
-    template <typename Config, typename Derived, typename SuperType>
-    const typename Config::id_t id_holder<Config, Derived, SuperType>::s_type_hierarchy__ = type_hierarchy_init_id__();
+        // the constness of the source is restored by cast_result_t
+        auto* root = const_cast<root_t*>(static_cast<root_t const*>(p));
+        if (not implements<interface_t>(*root))
+            return nullptr;
+
+        return static_cast<cast_result_t<TargetType, SourceType>>(
+            root->template type_hierarchy_interface_cast__<interface_t>(root)
+        );
+    }
+
+    template <typename TargetType, typename SourceType,
+        typename = std::enable_if_t<std::is_base_of<level_tag<0>, SourceType>::value> >
+    cast_result_t<TargetType, SourceType> dyn_cast(SourceType* p)
+    {
+        return dyn_cast_impl<TargetType>(cast_kind_t<TargetType, std::remove_cv_t<SourceType>>{}, p);
+    }
+
+    // dyn_cast_never<>() is the hook for ni::match to drop the cases of cross casts at compile time
+    template <typename TargetType, typename SourceType,
+        typename = std::enable_if_t<std::is_base_of<level_tag<0>, SourceType>::value> >
+    auto dyn_cast_never(SourceType const*) -> std::integral_constant< bool
+    ,   std::is_same<cast_kind_t<TargetType, std::remove_cv_t<SourceType>>, cross_cast>::value
+    >
+    {
+        return {};
+    }
 
 
     //------------------------------------------------------------------------------------------------------------------
-    // Casting
+    // Case Tables
     //------------------------------------------------------------------------------------------------------------------
 
-    template <typename TargetType, typename Config>
-    TargetType* dyn_cast(id_holder<Config>* p)
+    // dyn_case() is the hook for ni::match to select the case of a list of target types in O(1). It looks up the
+    // index of the first target type an object is convertible to in a case_table, which is a trie over the levels
+    // of the id: each node is indexed by the local id on its level and either resolves the case or points to the
+    // node of the next level. The table is built once per list of target types. If all target types have static
+    // ids the table is a compile time constant.
+    //
+    // Tables are only used for lists of at least `min_cases_for_case_table` target types and if the levels that
+    // need to be inspected have at most `max_case_table_bits` bits, otherwise ni::match falls back to try each case.
+
+    constexpr std::size_t min_cases_for_case_table = 4;
+    constexpr int max_case_table_bits = 8;
+
+    template <int... Ns>
+    constexpr int get_at(std::integer_sequence<int, Ns...>, int n)
     {
-        return convertible_to<TargetType>(*p) ? static_cast<TargetType*>(p) : nullptr;
+        return constexpr_array<int, sizeof...(Ns)>{{Ns...}}.data[n];
     }
 
-    template <typename TargetType, typename Config, typename T1>
-    TargetType* dyn_cast(id_holder<Config, T1, void>* p)
+    template <typename Config, typename T>
+    struct is_case_of : std::integral_constant< bool
+    ,   std::is_base_of<id_holder<Config>, T>::value or std::is_same<typename Config::base_type, T>::value
+    > {};
+
+    // the level on which a target type is decided, the root & user base are convertible from anything
+    template <typename Config, typename T>
+    constexpr int case_level_v = std::is_same<typename Config::base_type, T>::value ? 0 : level_of_v<T>;
+
+    template <typename Config, typename T>
+    constexpr typename Config::id_t case_id(std::true_type /* is base type */)
     {
-        return convertible_to<TargetType>(*p) ? static_cast<TargetType*>(p) : nullptr;
+        return 0;
     }
 
-    template <typename TargetType, typename Config>
-    TargetType const* dyn_cast(id_holder<Config> const* p)
+    template <typename Config, typename T>
+    constexpr typename Config::id_t case_id(std::false_type)
+    {
+        return id_of<T>::init();
+    }
+
+    template <typename Config, typename... Targets>
+    struct case_table_traits
+    {
+        static constexpr int levels[] = { 0, case_level_v<Config, Targets>... };
+
+        static constexpr int depth()
+        {
+            int d = 1;
+            for (int l : levels) d = l > d ? l : d;
+            return d;
+        }
+
+        static constexpr int bits()
+        {
+            int b = 0;
+            for (int l = 0; l < depth(); ++l)
+            {
+                int bl = get_at(typename Config::bits_per_level{}, l);
+                b = bl > b ? bl : b;
+            }
+            return b;
+        }
+
+        static constexpr std::size_t num_nodes()
+        {
+            std::size_t n = 1;
+            for (int l : levels) n += l > 1 ? std::size_t(l - 1) : 0;
+            return n;
+        }
+
+        static constexpr bool enabled = meta::fold_and_v<is_case_of<Config, Targets>::value...>
+                                    and sizeof...(Targets) >= min_cases_for_case_table
+                                    and sizeof...(Targets) < 0x7fff
+                                    and bits() <= max_case_table_bits;
+    };
+
+    template <typename Config, typename... Targets>
+    constexpr int case_table_traits<Config, Targets...>::levels[];
+
+
+    template <typename Config, int Depth, int Bits, std::size_t NumNodes>
+    struct case_table
+    {
+        using id_t = typename Config::id_t;
+
+        // entries >= 0 are case indices, entries < 0 are the negated indices of nodes on the next level
+        std::int16_t  entries[NumNodes << Bits];
+        int           shifts[Depth];
+        std::size_t   masks[Depth];
+
+        std::size_t lookup(id_t id) const
+        {
+            std::size_t node = 0;
+            for (int level = 0; ; ++level)
+            {
+                auto entry = entries[(node << Bits) + (static_cast<std::size_t>(id >> shifts[level]) & masks[level])];
+                if (entry >= 0)
+                    return static_cast<std::size_t>(entry);
+                node = static_cast<std::size_t>(-entry);
+            }
+        }
+    };
+
+    template <typename Config, typename... Targets>
+    using case_table_t = case_table
+    <   Config
+    ,   case_table_traits<Config, Targets...>::depth()
+    ,   case_table_traits<Config, Targets...>::bits()
+    ,   case_table_traits<Config, Targets...>::num_nodes()
+    >;
+
+    template <typename Config, typename... Targets>
+    constexpr case_table_t<Config, Targets...> make_case_table()
+    {
+        using id_t = typename Config::id_t;
+        using traits = case_table_traits<Config, Targets...>;
+        using bits_t = typename Config::bits_per_level;
+        using shifts_t = typename Config::level_shifts;
+
+        constexpr std::size_t num_cases = sizeof...(Targets);
+        constexpr int depth = traits::depth();
+        constexpr int bits = traits::bits();
+        const id_t ids[] = { 0, case_id<Config, Targets>(std::is_same<typename Config::base_type, Targets>{})... };
+
+        case_table_t<Config, Targets...> table{};
+        for (int level = 0; level < depth; ++level)
+        {
+            table.shifts[level] = get_at(shifts_t{}, level);
+            table.masks[level] = low_bits<std::size_t>(get_at(bits_t{}, level));
+        }
+
+        id_t prefixes[traits::num_nodes()] = {};
+        int levels[traits::num_nodes()] = {};
+        std::size_t num_nodes = 1;
+
+        for (std::size_t node = 0; node < num_nodes; ++node)
+        {
+            int const level = levels[node];
+            for (std::size_t local = 0; local <= table.masks[level]; ++local)
+            {
+                id_t const prefix = prefixes[node] | (static_cast<id_t>(local) << table.shifts[level]);
+                id_t const prefix_mask = low_bits<id_t>(get_at(shifts_t{}, level + 1));
+                std::int16_t entry = static_cast<std::int16_t>(num_cases);
+
+                // the first case that is either decided on this level or might match on a deeper level
+                for (std::size_t k = 0; k < num_cases; ++k)
+                {
+                    int const case_level = traits::levels[k+1];
+                    if (case_level <= level + 1)
+                    {
+                        id_t const case_mask = low_bits<id_t>(get_at(shifts_t{}, case_level));
+                        if ((prefix & case_mask) == ids[k+1])
+                        {
+                            entry = static_cast<std::int16_t>(k);
+                            break;
+                        }
+                    }
+                    else if ((ids[k+1] & prefix_mask) == prefix)
+                    {
+                        prefixes[num_nodes] = prefix;
+                        levels[num_nodes] = level + 1;
+                        entry = static_cast<std::int16_t>(-static_cast<int>(num_nodes++));
+                        break;
+                    }
+                }
+
+                table.entries[(node << bits) + local] = entry;
+                if (local == table.masks[level])
+                    break;
+            }
+        }
+
+        return table;
+    }
+
+
+    template <typename... Targets, typename Config>
+    auto dyn_case(meta::type_list<Targets...>, id_holder<Config> const* p)
+    -> std::enable_if_t<case_table_traits<Config, std::remove_cv_t<Targets>...>::enabled, std::size_t>
     {
-        return convertible_to<TargetType>(*p) ? static_cast<TargetType*>(p) : nullptr;
+        static const auto table = make_case_table<Config, std::remove_cv_t<Targets>...>();
+        return table.lookup(p->type_hierarchy_id__());
     }
 
-    template <typename TargetType, typename Config, typename D>
-    TargetType const* dyn_cast(id_holder<Config, D, void> const* p)
+
+    // dyn_disjoint() is the hook for ni::adaptive_matcher, types of the tree on different paths never match the
+    // same object
+    template <typename Target1, typename Target2, typename Config>
+    auto dyn_disjoint(meta::type_list<Target1, Target2>, id_holder<Config> const*) -> std::integral_constant< bool
+    ,   is_case_of<Config, Target1>::value and is_case_of<Config, Target2>::value
+        and not std::is_same<Target1, Target2>::value
+        and not std::is_base_of<Target1, Target2>::value and not std::is_base_of<Target2, Target1>::value
+    >
+    {
+        return {};
+    }
+
+
+    // A hierarchy is closed if the client declares all types objects below the root can have, by declaring
+    // `closed<Root, Types...> type_hierarchy_closed(Root const*);` next to the types. The declaration is found by
+    // ADL, it doesn't need a definition. dyn_closed() is the hook for ni::match to detect exhaustive matches.
+    template <typename Root, typename... Types>
+    struct closed
+    {
+        static_assert( meta::fold_and_v<true, std::is_base_of<Root, Types>::value...>
+                     , "All types of a closed hierarchy must derive from its root." );
+
+        using types = meta::type_list<Types...>;
+    };
+
+    template <typename SourceType,
+        typename = std::enable_if_t<std::is_base_of<level_tag<0>, SourceType>::value> >
+    auto dyn_closed(SourceType const* p) -> typename decltype(type_hierarchy_closed(p))::types
     {
-        return convertible_to<TargetType>(*p) ? static_cast<TargetType const*>(p) : nullptr;
+        return {};
     }
 
 
+    //------------------------------------------------------------------------------------------------------------------
+    // 4. Registry
+    //------------------------------------------------------------------------------------------------------------------
+
+    // If the user defined base declares `using type_hierarchy_registry = ni::type_hierarchy::enable_registry;` each
+    // type is added to the registry during static initialization and removed when the binary that defines it is
+    // unloaded. The registration is triggered by the instantiation of the constructor. The registry itself is defined
+    // in type_hierarchy/registry.h.
+
+    template <typename Config>
+    struct type_registry;
+
+    template <typename Config, typename Derived, typename SuperType>
+    struct registration<Config, Derived, SuperType, true>
+    {
+        struct entry
+        {
+            entry() : id{type_registry<Config>::template add<Derived, SuperType>()} {}
+            ~entry() { type_registry<Config>::remove(id); }
+
+            entry(entry const&) = delete;
+            entry& operator=(entry const&) = delete;
+
+            typename Config::id_t const id;
+        };
+
+        static const entry registered;
+
+        static void touch()
+        {
+            static_cast<void>(&registered);
+        }
+    };
+
+    template <typename Config, typename Derived, typename SuperType>
+    const typename registration<Config, Derived, SuperType, true>::entry
+        registration<Config, Derived, SuperType, true>::registered{};
+
+
     //------------------------------------------------------------------------------------------------------------------
     // Configure & Build Hierarchy
     //------------------------------------------------------------------------------------------------------------------
 
-    template <int NumBits>
+    template <int NumBits, bool Wide = (NumBits > 64)>
     struct int_for_bits { using type = typename int_for_bits<NumBits+1>::type; };
 
     template <> struct int_for_bits<8>  { using type = std::uint8_t; };
@@ -347,6 +1250,10 @@ namespace type_hierarchy_detail {
     template <> struct int_for_bits<32> { using type = std::uint32_t; };
     template <> struct int_for_bits<64> { using type = std::uint64_t; };
 
+    // ids of more than 64 bits are multiples of 128 bits
+    template <int NumBits>
+    struct int_for_bits<NumBits, true> { using type = wide_id<std::size_t(NumBits + 127) / 128 * 2>; };
+
     template <typename BaseType, int... BitsPerLevel>
     struct builder
     {
@@ -356,6 +1263,7 @@ namespace type_hierarchy_detail {
             using bits_per_level = std::integer_sequence<int, BitsPerLevel...>;
             using level_shifts = meta::scan_add_t<int, 0, BitsPerLevel...>;
             using id_t = typename int_for_bits<meta::fold_add_v<int, BitsPerLevel...>>::type;
+            using interfaces = typename declared_interfaces<BaseType>::type;
         };
 
         using root_t = type_hierarchy_detail::id_holder<config>;
@@ -367,17 +1275,26 @@ namespace type_hierarchy_detail {
     template <typename BaseType, int... BitsPerLevel>
     using root_t = typename builder<BaseType, BitsPerLevel...>::root_t;
 
+    // the minimal number of bits for the local ids 1 to `num_types`, 0 is the id of the super type
+    constexpr int bits_for_types(std::uint64_t num_types)
+    {
+        int bits = 1;
+        while (bits < 64 and (num_types >> bits) != 0)
+            ++bits;
+        return bits;
+    }
 
-    template <typename Derived, typename Super>
+
+    template <typename Derived, typename Super, typename IdPolicy>
     struct sub_type_impl
     {
-        using type = id_holder<get_config_t<Super>, Derived, Super>;
+        using type = id_holder<get_config_t<Super>, Derived, Super, IdPolicy>;
     };
 
-    template <typename Derived, typename Config>
-    struct sub_type_impl<Derived, id_holder<Config>>
+    template <typename Derived, typename Config, typename IdPolicy>
+    struct sub_type_impl<Derived, id_holder<Config>, IdPolicy>
     {
-        using type = id_holder<Config, Derived, void>;
+        using type = id_holder<Config, Derived, void, IdPolicy>;
     };
 
 }
@@ -387,8 +1304,21 @@ namespace type_hierarchy {
     template <typename BaseType, int... BitsPerLevel>
     using from_base = type_hierarchy_detail::root_t<BaseType, BitsPerLevel...>;
 
-    template <typename Derived, typename Super>
-    using sub_type = typename type_hierarchy_detail::sub_type_impl<Derived, Super>::type;
+    // the root type of a hierarchy with at most `TypesPerLevel` types on each level and minimal ids
+    template <typename BaseType, std::uint64_t... TypesPerLevel>
+    using from_shape = type_hierarchy_detail::root_t<BaseType, type_hierarchy_detail::bits_for_types(TypesPerLevel)...>;
+
+    using type_hierarchy_detail::dynamic_id;
+    using type_hierarchy_detail::static_id;
+    using type_hierarchy_detail::hashed_id;
+    using type_hierarchy_detail::closed;
+
+    template <typename Derived, typename Super, typename IdPolicy = dynamic_id>
+    using sub_type = typename type_hierarchy_detail::sub_type_impl<Derived, Super, IdPolicy>::type;
+
+    // the id of a type with a static id as compile time constant, e.g. to be used in switch statements
+    template <typename T>
+    constexpr auto id_v = type_hierarchy_detail::static_id_of<T>::value;
 
     using type_hierarchy_detail::convertible_to;
 }
@@ -397,7 +1327,7 @@ using type_hierarchy::sub_type;
 using type_hierarchy::convertible_to;
 
 
-#define  NI_SUB_TYPE( DERIVED, SUPER )  DERIVED : public ni::sub_type< DERIVED, SUPER >
+#define  NI_SUB_TYPE( DERIVED, ... )  DERIVED : public ni::sub_type< DERIVED, __VA_ARGS__ >
 
 
 } // ::ni
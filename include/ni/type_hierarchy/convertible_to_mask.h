@@ -0,0 +1,226 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+
+//!---------------------------------------------------------------------------------------------------------------------
+//!
+//!  \file
+//!
+//!  `convertible_to_mask<T>` applies the test of `ni::convertible_to<T>` to a whole array of type ids at once. It
+//!  sets bit `i % 64` of word `i / 64` of the result if the object with the id `ids[i]` is convertible to T.
+//!
+//!  With SSE2 or AVX2 enabled (e.g. `-mavx2`) 2 to 32 ids are compared per instruction depending on the size of the
+//!  ids, otherwise a scalar loop is used. Define `NI_TYPE_HIERARCHY_NO_SIMD` to always use the scalar loop.
+//!
+//!  Example
+//!  ```
+//!  std::vector<Event::id_t> ids = …;
+//!  std::vector<std::uint64_t> bits((ids.size() + 63) / 64);
+//!
+//!  ni::type_hierarchy::convertible_to_mask<MouseEvent>(ids.data(), ids.size(), bits.data());
+//!  ```
+//!
+//!---------------------------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <ni/type_hierarchy.h>
+#include <ni/type_hierarchy/simd.h>
+
+#include <boost/assert.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ni {
+
+namespace type_hierarchy_detail {
+
+    // masked_equal<Id> compares `width` ids with `(id & mask) == value` and returns one bit per id
+
+    template <typename Id>
+    struct masked_equal_scalar
+    {
+        static constexpr std::size_t width = 1;
+
+        static std::uint64_t apply(Id const* ids, Id mask, Id value)
+        {
+            return equal_under_mask(*ids, mask, value);
+        }
+    };
+
+#if defined(NI_TYPE_HIERARCHY_SSE2)
+
+    // wide ids are compared one at a time, see wide_id
+    template <typename Id>
+    struct masked_equal_sse2 : masked_equal_scalar<Id> {};
+
+    template <>
+    struct masked_equal_sse2<std::uint8_t>
+    {
+        static constexpr std::size_t width = 16;
+
+        static std::uint64_t apply(std::uint8_t const* ids, std::uint8_t mask, std::uint8_t value)
+        {
+            auto const x = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<__m128i const*>(ids)), _mm_set1_epi8(char(mask)));
+            return std::uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_set1_epi8(char(value)))));
+        }
+    };
+
+    template <>
+    struct masked_equal_sse2<std::uint16_t>
+    {
+        static constexpr std::size_t width = 8;
+
+        static std::uint64_t apply(std::uint16_t const* ids, std::uint16_t mask, std::uint16_t value)
+        {
+            auto const x = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<__m128i const*>(ids)), _mm_set1_epi16(short(mask)));
+            auto const eq = _mm_cmpeq_epi16(x, _mm_set1_epi16(short(value)));
+            return std::uint32_t(_mm_movemask_epi8(_mm_packs_epi16(eq, _mm_setzero_si128())));
+        }
+    };
+
+    template <>
+    struct masked_equal_sse2<std::uint32_t>
+    {
+        static constexpr std::size_t width = 4;
+
+        static std::uint64_t apply(std::uint32_t const* ids, std::uint32_t mask, std::uint32_t value)
+        {
+            auto const x = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<__m128i const*>(ids)), _mm_set1_epi32(int(mask)));
+            auto const eq = _mm_cmpeq_epi32(x, _mm_set1_epi32(int(value)));
+            return std::uint32_t(_mm_movemask_ps(_mm_castsi128_ps(eq)));
+        }
+    };
+
+    template <>
+    struct masked_equal_sse2<std::uint64_t>
+    {
+        static constexpr std::size_t width = 2;
+
+        static std::uint64_t apply(std::uint64_t const* ids, std::uint64_t mask, std::uint64_t value)
+        {
+            // SSE2 has no 64 bit compare, both 32 bit halves have to be equal
+            auto const x = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<__m128i const*>(ids)), _mm_set1_epi64x(std::int64_t(mask)));
+            auto const eq32 = _mm_cmpeq_epi32(x, _mm_set1_epi64x(std::int64_t(value)));
+            auto const eq = _mm_and_si128(eq32, _mm_shuffle_epi32(eq32, _MM_SHUFFLE(2, 3, 0, 1)));
+            return std::uint32_t(_mm_movemask_pd(_mm_castsi128_pd(eq)));
+        }
+    };
+
+#endif
+
+#if defined(NI_TYPE_HIERARCHY_AVX2)
+
+    template <typename Id>
+    struct masked_equal_avx2 : masked_equal_sse2<Id> {};
+
+    template <>
+    struct masked_equal_avx2<std::uint8_t>
+    {
+        static constexpr std::size_t width = 32;
+
+        static std::uint64_t apply(std::uint8_t const* ids, std::uint8_t mask, std::uint8_t value)
+        {
+            auto const x = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(ids)), _mm256_set1_epi8(char(mask)));
+            return std::uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(char(value)))));
+        }
+    };
+
+    template <>
+    struct masked_equal_avx2<std::uint32_t>
+    {
+        static constexpr std::size_t width = 8;
+
+        static std::uint64_t apply(std::uint32_t const* ids, std::uint32_t mask, std::uint32_t value)
+        {
+            auto const x = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(ids)), _mm256_set1_epi32(int(mask)));
+            auto const eq = _mm256_cmpeq_epi32(x, _mm256_set1_epi32(int(value)));
+            return std::uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(eq)));
+        }
+    };
+
+    template <>
+    struct masked_equal_avx2<std::uint64_t>
+    {
+        static constexpr std::size_t width = 4;
+
+        static std::uint64_t apply(std::uint64_t const* ids, std::uint64_t mask, std::uint64_t value)
+        {
+            auto const x = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(ids)), _mm256_set1_epi64x(std::int64_t(mask)));
+            auto const eq = _mm256_cmpeq_epi64(x, _mm256_set1_epi64x(std::int64_t(value)));
+            return std::uint32_t(_mm256_movemask_pd(_mm256_castsi256_pd(eq)));
+        }
+    };
+
+    template <typename Id>
+    using masked_equal = masked_equal_avx2<Id>;
+
+#elif defined(NI_TYPE_HIERARCHY_SSE2)
+
+    template <typename Id>
+    using masked_equal = masked_equal_sse2<Id>;
+
+#else
+
+    template <typename Id>
+    using masked_equal = masked_equal_scalar<Id>;
+
+#endif
+
+
+    // compares up to 64 ids, bit i of the result is set if (ids[i] & mask) == value
+    template <typename Id>
+    std::uint64_t masked_equal_bits(Id const* ids, std::size_t n, Id mask, Id value)
+    {
+        BOOST_ASSERT_MSG( n <= 64, "At most 64 ids can be compared at once." );
+
+        using kernel_t = masked_equal<Id>;
+
+        std::uint64_t bits = 0;
+        std::size_t i = 0;
+        for (; i + kernel_t::width <= n; i += kernel_t::width)
+            bits |= kernel_t::apply(ids + i, mask, value) << i;
+        for (; i < n; ++i)
+            bits |= masked_equal_scalar<Id>::apply(ids + i, mask, value) << i;
+        return bits;
+    }
+
+
+    // the mask and value to compare the ids with, the root type matches any id
+    template <typename T>
+    struct convertible_to_test
+    {
+        using config_t = get_config_t<T>;
+        using id_t = typename config_t::id_t;
+
+        id_t mask = mask_v<config_t, T>;
+        id_t value = id_of<std::remove_cv_t<T>>::init();
+    };
+
+    template <typename T, typename Id>
+    void convertible_to_mask(Id const* ids, std::size_t n, std::uint64_t* bits)
+    {
+        static_assert( std::is_same<Id, typename get_config_t<T>::id_t>::value, "Ids must have the id type of T's type_hierarchy." );
+
+        convertible_to_test<T> const test;
+        for (std::size_t i = 0; i < n; i += 64)
+            *bits++ = masked_equal_bits(ids + i, n - i < 64 ? n - i : 64, test.mask, test.value);
+    }
+
+}
+
+namespace type_hierarchy {
+
+    using type_hierarchy_detail::convertible_to_mask;
+
+}
+
+}
@@ -0,0 +1,141 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+
+//!---------------------------------------------------------------------------------------------------------------------
+//!  \file
+//!
+//!  `dispatch_trie` maps the ids of a `type_hierarchy` to small integers with one table lookup per level of the id.
+//!  It's built at runtime from the ids of the types a container or function knows about. Ids of types that have not
+//!  been inserted map to the value of their nearest inserted super type. Levels can have at most 16 bits, since each
+//!  node has an entry for every local id of its level.
+//!
+//!---------------------------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <ni/meta/fold_and.h>
+#include <ni/type_hierarchy.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ni {
+
+namespace type_hierarchy_detail {
+
+    constexpr int max_dispatch_trie_bits = 16;
+
+    template <int... Bits>
+    constexpr bool fits_dispatch_trie(std::integer_sequence<int, Bits...>)
+    {
+        return meta::fold_and_v<(Bits <= max_dispatch_trie_bits)...>;
+    }
+
+    // Maps ids to values with the fallback to the nearest ancestor. The entries of the node of level L are indexed by
+    // the local id of level L. An entry >= 0 is a value, an entry < 0 the negated offset of the node of the next
+    // level. The entry 0 of each node is the value of the node's type itself.
+    template <typename Config>
+    class dispatch_trie
+    {
+        static_assert( fits_dispatch_trie(typename Config::bits_per_level{})
+                     , "The levels of the type_hierarchy are too wide for a dispatch_trie." );
+
+    public:
+
+        using id_t = typename Config::id_t;
+
+        static constexpr int num_levels = int(typename Config::bits_per_level{}.size());
+
+        explicit dispatch_trie(std::int32_t root_value)
+        {
+            add_node(0, root_value);
+        }
+
+        // values must be inserted super types first
+        void insert(id_t id, std::int32_t value)
+        {
+            auto const depth = depth_of(id);
+            if (depth == 0)
+            {
+                std::fill(m_entries.begin(), m_entries.begin() + node_size(0), value);
+                return;
+            }
+
+            std::size_t offset = 0;
+            for (int level = 0; level < depth - 1; ++level)
+            {
+                auto const i = offset + local_id(id, level);
+                if (m_entries[i] >= 0)
+                {
+                    auto const child = add_node(level + 1, m_entries[i]);
+                    m_entries[i] = -std::int32_t(child);
+                }
+                offset = std::size_t(-m_entries[i]);
+            }
+
+            auto& entry = m_entries[offset + local_id(id, depth - 1)];
+            if (entry >= 0)
+                entry = value;
+            else
+                m_entries[std::size_t(-entry)] = value;
+        }
+
+        std::int32_t lookup(id_t id) const
+        {
+            std::size_t offset = 0;
+            for (int level = 0; level < num_levels; ++level)
+            {
+                auto const e = m_entries[offset + local_id(id, level)];
+                if (e >= 0)
+                    return e;
+                offset = std::size_t(-e);
+            }
+            return m_entries[offset];
+        }
+
+        // the number of levels with a non-zero local id
+        static int depth_of(id_t id)
+        {
+            int depth = 0;
+            for (int level = 0; level < num_levels; ++level)
+                if (local_id(id, level) != 0)
+                    depth = level + 1;
+            return depth;
+        }
+
+    private:
+
+        static std::size_t local_id(id_t id, int level)
+        {
+            auto const shift = get_at(typename Config::level_shifts{}, level);
+            return std::size_t((id >> shift) & low_bits<id_t>(get_at(typename Config::bits_per_level{}, level)));
+        }
+
+        static std::size_t node_size(int level)
+        {
+            return std::size_t(1) << get_at(typename Config::bits_per_level{}, level);
+        }
+
+        std::size_t add_node(int level, std::int32_t value)
+        {
+            auto const offset = m_entries.size();
+            m_entries.resize(offset + node_size(level), value);
+            return offset;
+        }
+
+        std::vector<std::int32_t> m_entries;
+    };
+
+}
+
+}
@@ -0,0 +1,300 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+
+//!---------------------------------------------------------------------------------------------------------------------
+//!
+//!  \file
+//!
+//!  `ni::type_hierarchy::factory<Root>` constructs objects of a `type_hierarchy` from their id, e.g. to decode
+//!  streams of mixed types. Types are added with `define<T>()` and must be constructible from
+//!  `ni::type_hierarchy::bytes`, the serialized data of the object. The constructor is then found in O(1) via the
+//!  id, with one table lookup per level of the id. `define` returns a handle that removes the type again when it's
+//!  destroyed, e.g. when a plugin that defined it is unloaded, so that the type can be defined again later.
+//!
+//!  Example
+//!  ```
+//!  struct MouseEvent : ni::sub_type<MouseEvent, Event>
+//!  {
+//!      MouseEvent(ni::type_hierarchy::bytes data) { ... }
+//!  };
+//!
+//!  static auto const define_mouse_event = ni::type_hierarchy::factory<Event>::define<MouseEvent>();
+//!
+//!  // allocates from a memory resource, nullptr if the id is unknown
+//!  Event* e = ni::type_hierarchy::create<Event>(id, resource, {data, size});
+//!  ...
+//!  ni::type_hierarchy::factory<Event>::destroy(e, resource);
+//!
+//!  // or constructs into storage provided by the caller
+//!  auto const* info = ni::type_hierarchy::factory<Event>::find(id);
+//!  Event* e = info->construct(storage, {data, size});   // storage of info->size bytes aligned to info->alignment
+//!  ```
+//!
+//!  Memory resources can be anything with `allocate(size, alignment)` and `deallocate(p, size, alignment)`, e.g.
+//!  `std::pmr::memory_resource` or `boost::container::pmr::memory_resource`.
+//!
+//!  Every level of the id on the path to a defined type gets a table with one entry per possible local id, so the
+//!  factory requires hierarchies with at most 16 bits per level, like the default 8.
+//!
+//!  The table is rebuilt on the first lookup after types have been added or removed. Lookups can run concurrently with
+//!  each other and with `define`, but a type must not be removed while objects of it are being created or destroyed.
+//!
+//!---------------------------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <ni/type_hierarchy.h>
+#include <ni/type_hierarchy/dispatch_trie.h>
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace ni {
+
+namespace type_hierarchy {
+
+    //! The serialized data an object is constructed from
+    struct bytes
+    {
+        void const*  data;
+        std::size_t  size;
+    };
+
+
+    template <typename Root>
+    class factory
+    {
+        using config_t = type_hierarchy_detail::get_config_t<Root>;
+        static_assert( not std::is_void<config_t>::value, "Root must be a type of a type_hierarchy." );
+        static_assert( type_hierarchy_detail::fits_dispatch_trie(typename config_t::bits_per_level{})
+                     , "The factory requires a type_hierarchy with at most 16 bits per level."
+                     );
+
+    public:
+
+        using id_t = typename config_t::id_t;
+
+        struct constructor
+        {
+            id_t          id;
+            std::size_t   size;
+            std::size_t   alignment;
+            Root*         (*construct)(void* storage, bytes data);
+            void*         (*destruct)(Root* p);
+        };
+
+    private:
+
+        struct definition : constructor
+        {
+            definition(constructor c) : constructor(c) {}
+            definition* next = nullptr;
+        };
+
+        struct remove_definition
+        {
+            void operator()(constructor const* c) const
+            {
+                auto* d = static_cast<definition*>(const_cast<constructor*>(c));
+                registry::instance().remove(d);
+                delete d;
+            }
+        };
+
+    public:
+
+        //! Removes the constructor when destroyed
+        using handle = std::unique_ptr<constructor const, remove_definition>;
+
+        //! Adds the constructor of T, e.g. to initialize a static variable that lives as long as T can be created
+        template <typename T>
+        static handle define()
+        {
+            static_assert( std::is_base_of<Root, T>::value, "T must be derived from Root." );
+            static_assert( std::is_constructible<T, bytes>::value, "T must be constructible from bytes." );
+
+            auto const id = type_hierarchy_detail::id_of<T>::init();
+            auto* d = new definition{{id, sizeof(T), alignof(T), &construct<T>, &destruct<T>}};
+            registry::instance().add(d);
+            return handle{d};
+        }
+
+        //! The constructor of the type with the given id, nullptr if there is none
+        static constructor const* find(id_t id)
+        {
+            auto const* t = registry::instance().current();
+            auto const* c = t->constructors[std::size_t(t->trie.lookup(id))];
+            return c and c->id == id ? c : nullptr;
+        }
+
+        //! Allocates and constructs the object of type `id`, returns nullptr if the id is unknown
+        template <typename MemoryResource>
+        static Root* create(id_t id, MemoryResource& resource, bytes data)
+        {
+            auto const* c = find(id);
+            if (c == nullptr)
+                return nullptr;
+
+            void* storage = resource.allocate(c->size, c->alignment);
+            try
+            {
+                return c->construct(storage, data);
+            }
+            catch (...)
+            {
+                resource.deallocate(storage, c->size, c->alignment);
+                throw;
+            }
+        }
+
+        //! Destroys and deallocates an object that has been created with `create`
+        template <typename MemoryResource>
+        static void destroy(Root* p, MemoryResource& resource)
+        {
+            if (p == nullptr)
+                return;
+
+            auto const* c = find(static_cast<type_hierarchy_detail::id_holder<config_t> const*>(p)->type_hierarchy_id__());
+            BOOST_ASSERT_MSG( c != nullptr, "Type has not been defined." );
+            resource.deallocate(c->destruct(p), c->size, c->alignment);
+        }
+
+    private:
+
+        struct table
+        {
+            type_hierarchy_detail::dispatch_trie<config_t>  trie{0};
+            std::vector<constructor const*>                 constructors{ nullptr };
+            std::unique_ptr<table const>                    retired;
+        };
+
+        class registry
+        {
+        public:
+
+            static registry& instance()
+            {
+                static registry r;
+                return r;
+            }
+
+            ~registry()
+            {
+                delete m_table.load(std::memory_order_relaxed);
+            }
+
+            void add(definition* d)
+            {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                BOOST_ASSERT_MSG( find_definition(d->id) == nullptr, "Type has already been defined." );
+                d->next = m_definitions;
+                m_definitions = d;
+                m_stale.store(true, std::memory_order_release);
+            }
+
+            void remove(definition* d)
+            {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                for (auto** p = &m_definitions; *p; p = &(*p)->next)
+                    if (*p == d)
+                    {
+                        *p = d->next;
+                        break;
+                    }
+                m_stale.store(true, std::memory_order_release);
+            }
+
+            table const* current()
+            {
+                return m_stale.load(std::memory_order_acquire) ? rebuild() : m_table.load(std::memory_order_acquire);
+            }
+
+        private:
+
+            definition* find_definition(id_t id) const
+            {
+                for (auto* d = m_definitions; d; d = d->next)
+                    if (d->id == id)
+                        return d;
+                return nullptr;
+            }
+
+            // builds the table from the current definitions, previous tables are kept since they might still be in use
+            table const* rebuild()
+            {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                if (not m_stale.load(std::memory_order_relaxed))
+                    return m_table.load(std::memory_order_relaxed);
+
+                std::vector<constructor const*> constructors;
+                for (auto* d = m_definitions; d; d = d->next)
+                    constructors.push_back(d);
+
+                using trie_t = type_hierarchy_detail::dispatch_trie<config_t>;
+                std::stable_sort(constructors.begin(), constructors.end(), [](auto* a, auto* b)
+                {
+                    return trie_t::depth_of(a->id) < trie_t::depth_of(b->id);
+                });
+
+                auto t = std::make_unique<table>();
+                for (auto* c : constructors)
+                {
+                    t->trie.insert(c->id, std::int32_t(t->constructors.size()));
+                    t->constructors.push_back(c);
+                }
+
+                t->retired.reset(m_table.load(std::memory_order_relaxed));
+                m_table.store(t.release(), std::memory_order_release);
+                m_stale.store(false, std::memory_order_release);
+                return m_table.load(std::memory_order_relaxed);
+            }
+
+            std::mutex                  m_mutex;
+            definition*                 m_definitions = nullptr;
+            std::atomic<table const*>   m_table{nullptr};
+            std::atomic<bool>           m_stale{true};
+        };
+
+        template <typename T>
+        static Root* construct(void* storage, bytes data)
+        {
+            return ::new (storage) T(data);
+        }
+
+        template <typename T>
+        static void* destruct(Root* p)
+        {
+            T* t = static_cast<T*>(p);
+            t->~T();
+            return t;
+        }
+    };
+
+
+    //! Allocates and constructs the object of type `id` of the hierarchy of Root, see factory
+    template <typename Root, typename MemoryResource>
+    Root* create(typename factory<Root>::id_t id, MemoryResource& resource, bytes data)
+    {
+        return factory<Root>::create(id, resource, data);
+    }
+
+}
+
+}
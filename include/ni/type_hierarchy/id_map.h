@@ -0,0 +1,116 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+
+//!---------------------------------------------------------------------------------------------------------------------
+//!  \file
+//!
+//!  `id_map` is a small open addressing hash map from type ids to values that is used by the containers of the
+//!  `type_hierarchy` to find per-type data in O(1). The id 0 is reserved as empty marker, this is the id of the
+//!  root which can't be instantiated anyway.
+//!
+//!  Lookups are lock-free and can run concurrently, inserting must not run concurrently with anything else.
+//!
+//!---------------------------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <ni/type_hierarchy/wide_id.h>
+
+#include <boost/assert.hpp>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ni {
+
+namespace type_hierarchy_detail {
+
+    template <typename Id, typename Value>
+    class id_map
+    {
+    public:
+
+        Value const* find(Id id) const
+        {
+            if (m_entries.empty())
+                return nullptr;
+
+            auto const mask = m_entries.size() - 1;
+            for (auto i = hash(id) & mask; ; i = (i + 1) & mask)
+            {
+                auto const& e = m_entries[i];
+                if (e.first == id)
+                    return &e.second;
+                if (e.first == Id{})
+                    return nullptr;
+            }
+        }
+
+        Value* find(Id id)
+        {
+            return const_cast<Value*>(static_cast<id_map const*>(this)->find(id));
+        }
+
+        void insert(Id id, Value value)
+        {
+            BOOST_ASSERT_MSG( id != Id{}, "The id 0 is reserved." );
+            BOOST_ASSERT_MSG( find(id) == nullptr, "The id is already in the map." );
+
+            if (2 * (m_size + 1) > m_entries.size())
+                rehash(m_entries.empty() ? 8 : 2 * m_entries.size());
+
+            place(m_entries, id, std::move(value));
+            ++m_size;
+        }
+
+        std::size_t size() const { return m_size; }
+
+        void clear()
+        {
+            m_entries.clear();
+            m_size = 0;
+        }
+
+    private:
+
+        using entry_t = std::pair<Id, Value>;
+
+        static std::size_t hash(Id id)
+        {
+            return std::size_t((fold_id(id) * 0x9E3779B97F4A7C15ull) >> 32);
+        }
+
+        static void place(std::vector<entry_t>& entries, Id id, Value value)
+        {
+            auto const mask = entries.size() - 1;
+            auto i = hash(id) & mask;
+            while (entries[i].first != Id{})
+                i = (i + 1) & mask;
+            entries[i] = entry_t{id, std::move(value)};
+        }
+
+        void rehash(std::size_t size)
+        {
+            std::vector<entry_t> entries(size, entry_t{Id{}, Value{}});
+            for (auto& e : m_entries)
+                if (e.first != Id{})
+                    place(entries, e.first, std::move(e.second));
+            m_entries = std::move(entries);
+        }
+
+        std::vector<entry_t>  m_entries;
+        std::size_t           m_size = 0;
+    };
+
+}
+
+}
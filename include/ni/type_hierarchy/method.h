@@ -0,0 +1,265 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+
+//!---------------------------------------------------------------------------------------------------------------------
+//!
+//!  \file
+//!
+//!  `ni::type_hierarchy::method<Root, Signature>` is an open method on the types of a `type_hierarchy`: a function
+//!  that dispatches on the dynamic type of its first argument like a virtual function, but whose implementations
+//!  can be added for any type from any translation unit without touching the types or a central matcher.
+//!
+//!  A call selects the implementation of the most derived type the object is convertible to. It looks up the id of
+//!  the object level by level in a table which maps each local id to either an implementation or the table of the
+//!  next level. The fallback to the nearest ancestor is precomputed, so a call costs one load per level of the id.
+//!
+//!  Example
+//!  ```
+//!  // events.h
+//!  extern ni::type_hierarchy::method<Event, void(Event const&, Canvas&)> draw;
+//!
+//!  // events.cpp
+//!  ni::type_hierarchy::method<Event, void(Event const&, Canvas&)> draw;
+//!
+//!  // mouse.cpp
+//!  static auto const draw_mouse = draw.define<MouseEvent>([](MouseEvent const& e, Canvas& c) { ... });
+//!
+//!  // key.cpp
+//!  static auto const draw_key = draw.define<KeyEvent>([](KeyEvent const& e, Canvas& c) { ... });
+//!  static auto const draw_any = draw.define<Event>([](Event const& e, Canvas& c) { ... });  // default
+//!
+//!  draw(event, canvas);
+//!  ```
+//!
+//!  Methods are constant initialized, so implementations can be defined during static initialization of any
+//!  translation unit. `define` returns a handle that removes the implementation again when it's destroyed. The
+//!  table is rebuilt on the first call after implementations have been added or removed. Calls can run concurrently
+//!  with each other and with `define`, but an implementation must not be removed while it is being called.
+//!
+//!  If there's no implementation for the type of the object nor for any of its super types the call throws
+//!  `ni::type_hierarchy::method_not_implemented`.
+//!
+//!  Every level of the id on the path to a type with an implementation gets a table with one entry per possible
+//!  local id, i.e. methods are meant for hierarchies with moderate bits per level like the default 8. Levels of more
+//!  than 16 bits are rejected at compile time.
+//!
+//!---------------------------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <ni/type_hierarchy.h>
+#include <ni/type_hierarchy/dispatch_trie.h>
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ni {
+
+namespace type_hierarchy {
+
+    struct method_not_implemented : std::logic_error
+    {
+        method_not_implemented() : std::logic_error{"No implementation of method for the type of the object."} {}
+    };
+
+
+    template <typename Root, typename Signature>
+    class method;
+
+    template <typename Root, typename R, typename Self, typename... Args>
+    class method<Root, R(Self, Args...)>
+    {
+        using config_t = type_hierarchy_detail::get_config_t<Root>;
+        using id_t = typename config_t::id_t;
+        using self_t = std::remove_reference_t<Self>;
+
+        static_assert( not std::is_void<config_t>::value, "Root must be a type of a type_hierarchy." );
+        static_assert( std::is_reference<Self>::value and std::is_same<std::remove_cv_t<self_t>, Root>::value
+                     , "The first parameter of the method must be a reference to Root."
+                     );
+        static_assert( type_hierarchy_detail::fits_dispatch_trie(typename config_t::bits_per_level{})
+                     , "Methods require a type_hierarchy with at most 16 bits per level."
+                     );
+
+        template <typename T>
+        using self_as_t = std::conditional_t<std::is_const<self_t>::value, T const&, T&>;
+
+        struct implementation_base
+        {
+            using invoke_t = R (*)(implementation_base const*, self_t&, Args&&...);
+
+            implementation_base(id_t id_, invoke_t invoke_) : id{id_}, invoke{invoke_} {}
+            virtual ~implementation_base() = default;
+
+            id_t                  id;
+            invoke_t              invoke;
+            method*               owner = nullptr;
+            implementation_base*  next = nullptr;
+        };
+
+        template <typename T, typename Function>
+        struct implementation : implementation_base
+        {
+            implementation(Function f_)
+            :   implementation_base{type_hierarchy_detail::id_of<T>::init(), &call}
+            ,   f{std::move(f_)}
+            {}
+
+            static R call(implementation_base const* self, self_t& x, Args&&... args)
+            {
+                return static_cast<implementation const*>(self)->f(static_cast<self_as_t<T>>(x), std::forward<Args>(args)...);
+            }
+
+            Function f;
+        };
+
+        struct table
+        {
+            explicit table(std::int32_t root_value) : trie{root_value} {}
+
+            type_hierarchy_detail::dispatch_trie<config_t>     trie;
+            std::vector<implementation_base const*>            implementations;
+            std::unique_ptr<table const>                       retired;
+        };
+
+        struct remove_implementation
+        {
+            void operator()(implementation_base* impl) const
+            {
+                if (impl->owner)
+                    impl->owner->remove(impl);
+                delete impl;
+            }
+        };
+
+    public:
+
+        //! Removes the implementation when destroyed
+        using handle = std::unique_ptr<implementation_base, remove_implementation>;
+
+        constexpr method() noexcept {}
+        method(method const&) = delete;
+        method& operator=(method const&) = delete;
+
+        ~method()
+        {
+            for (auto* impl = m_implementations; impl; impl = impl->next)
+                impl->owner = nullptr;
+            delete m_table.load(std::memory_order_relaxed);
+        }
+
+        //! Adds the implementation `f` for objects convertible to T, replacing the implementations of super types
+        template <typename T, typename Function>
+        handle define(Function f)
+        {
+            static_assert( std::is_base_of<Root, T>::value or std::is_same<Root, T>::value, "T must be derived from Root." );
+
+            handle impl{new implementation<T, Function>{std::move(f)}};
+
+            std::lock_guard<std::mutex> lock{m_mutex};
+            BOOST_ASSERT_MSG( find(impl->id) == nullptr, "Method has already been defined for this type." );
+            impl->owner = this;
+            impl->next = m_implementations;
+            m_implementations = impl.get();
+            m_stale.store(true, std::memory_order_release);
+            return impl;
+        }
+
+        //! Invokes the implementation of the most derived type x is convertible to
+        R operator()(Self x, Args... args) const
+        {
+            auto const* t = m_stale.load(std::memory_order_acquire) ? rebuild() : m_table.load(std::memory_order_acquire);
+            auto const id = static_cast<type_hierarchy_detail::id_holder<config_t> const&>(x).type_hierarchy_id__();
+            auto const* impl = t->implementations[std::size_t(t->trie.lookup(id))];
+            if (impl == nullptr)
+                throw method_not_implemented{};
+            return impl->invoke(impl, x, std::forward<Args>(args)...);
+        }
+
+        //! Tests if there is an implementation for objects of type T
+        template <typename T>
+        bool implemented_for() const
+        {
+            auto const* t = m_stale.load(std::memory_order_acquire) ? rebuild() : m_table.load(std::memory_order_acquire);
+            return t->implementations[std::size_t(t->trie.lookup(type_hierarchy_detail::id_of<T>::init()))] != nullptr;
+        }
+
+    private:
+
+        implementation_base* find(id_t id) const
+        {
+            for (auto* impl = m_implementations; impl; impl = impl->next)
+                if (impl->id == id)
+                    return impl;
+            return nullptr;
+        }
+
+        void remove(implementation_base* impl)
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            for (auto** p = &m_implementations; *p; p = &(*p)->next)
+                if (*p == impl)
+                {
+                    *p = impl->next;
+                    break;
+                }
+            m_stale.store(true, std::memory_order_release);
+        }
+
+        // builds the table from the current implementations, previous tables are kept since they might still be in use
+        table const* rebuild() const
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            if (not m_stale.load(std::memory_order_relaxed))
+                return m_table.load(std::memory_order_relaxed);
+
+            std::vector<implementation_base const*> implementations;
+            for (auto* impl = m_implementations; impl; impl = impl->next)
+                implementations.push_back(impl);
+
+            using trie_t = type_hierarchy_detail::dispatch_trie<config_t>;
+            std::stable_sort(implementations.begin(), implementations.end(), [](auto* a, auto* b)
+            {
+                return trie_t::depth_of(a->id) < trie_t::depth_of(b->id);
+            });
+
+            auto t = std::make_unique<table>(0);
+            t->implementations.push_back(nullptr);
+            for (auto* impl : implementations)
+            {
+                t->trie.insert(impl->id, std::int32_t(t->implementations.size()));
+                t->implementations.push_back(impl);
+            }
+
+            t->retired.reset(m_table.load(std::memory_order_relaxed));
+            m_table.store(t.release(), std::memory_order_release);
+            m_stale.store(false, std::memory_order_release);
+            return m_table.load(std::memory_order_relaxed);
+        }
+
+        mutable std::mutex                          m_mutex;
+        implementation_base*                        m_implementations = nullptr;
+        mutable std::atomic<table const*>           m_table{nullptr};
+        mutable std::atomic<bool>                   m_stale{true};
+    };
+
+}
+
+}
@@ -0,0 +1,194 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+
+//!---------------------------------------------------------------------------------------------------------------------
+//!
+//!  \file
+//!
+//!  `ni::views::of_type<T>` is a lazy view of the objects of a range that are convertible to the `type_hierarchy`
+//!  type T. It yields references to T, so filtering and casting happen in one pass. The range can contain objects,
+//!  raw pointers or smart pointers, null pointers are skipped.
+//!
+//!  The view reads the ids of blocks of 64 objects and tests them at once with `convertible_to_mask<T>`, the
+//!  iterator then walks the set bits of the block.
+//!
+//!  Example
+//!  ```
+//!  std::vector<std::unique_ptr<Event>> events = …;
+//!
+//!  for (MouseEvent& e : ni::views::of_type<MouseEvent>(events))
+//!      handle(e);
+//!
+//!  for (MouseEvent const& e : events | ni::views::of_type<MouseEvent const>)
+//!      handle(e);
+//!  ```
+//!
+//!  Iterators of the view are forward iterators. They are invalidated if the underlying range is modified.
+//!
+//!---------------------------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <ni/type_hierarchy.h>
+#include <ni/type_hierarchy/convertible_to_mask.h>
+#include <ni/functional/match.h>
+
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+namespace ni {
+
+namespace type_hierarchy_detail {
+
+    inline int count_trailing_zeros(std::uint64_t x)
+    {
+    #if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, x);
+        return int(index);
+    #else
+        return __builtin_ctzll(x);
+    #endif
+    }
+
+
+    template <typename T, typename Range>
+    class of_type_view
+    {
+        using base_iterator_t = decltype(std::begin(std::declval<Range&>()));
+        using source_t = std::remove_pointer_t<::ni::detail::element_pointer_t<Range>>;
+        using config_t = get_config_t<source_t>;
+        using id_t = typename config_t::id_t;
+
+        static_assert( std::is_same<config_t, get_config_t<T>>::value, "T must be of the type_hierarchy of the range." );
+
+        static constexpr std::size_t block_size = 64;
+
+    public:
+
+        class iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::remove_cv_t<T>;
+            using difference_type = std::ptrdiff_t;
+            using reference = ::ni::detail::copy_const_t<T, source_t>&;
+            using pointer = ::ni::detail::copy_const_t<T, source_t>*;
+
+            iterator() = default;
+
+            reference operator*() const
+            {
+                return static_cast<reference>(*m_block[count_trailing_zeros(m_bits)]);
+            }
+
+            pointer operator->() const { return &**this; }
+
+            iterator& operator++()
+            {
+                m_bits &= m_bits - 1;
+                if (m_bits == 0)
+                    fill();
+                return *this;
+            }
+
+            iterator operator++(int)
+            {
+                auto copy = *this;
+                ++*this;
+                return copy;
+            }
+
+            friend bool operator==(iterator const& a, iterator const& b)
+            {
+                return a.m_next == b.m_next and a.m_bits == b.m_bits;
+            }
+
+            friend bool operator!=(iterator const& a, iterator const& b) { return not (a == b); }
+
+        private:
+            friend class of_type_view;
+
+            iterator(base_iterator_t next, base_iterator_t end, convertible_to_test<T> const& test)
+            :   m_next{next}, m_end{end}, m_test{test}
+            {
+                fill();
+            }
+
+            // reads blocks until one contains an object convertible to T
+            void fill()
+            {
+                std::array<id_t, block_size> ids;
+                while (m_bits == 0 and m_next != m_end)
+                {
+                    std::size_t n = 0;
+                    for (; n < block_size and m_next != m_end; ++m_next)
+                        if (auto* p = ::ni::detail::element_pointer(meta::try_t{}, *m_next))
+                        {
+                            m_block[n] = p;
+                            ids[n++] = static_cast<id_holder<config_t> const*>(p)->type_hierarchy_id__();
+                        }
+                    m_bits = masked_equal_bits(ids.data(), n, m_test.mask, m_test.value);
+                }
+            }
+
+            base_iterator_t                     m_next{};
+            base_iterator_t                     m_end{};
+            convertible_to_test<T>              m_test{};
+            std::uint64_t                       m_bits = 0;
+            std::array<source_t*, block_size>   m_block{};
+        };
+
+        explicit of_type_view(Range& range) : m_range{&range} {}
+
+        iterator begin() const { return {std::begin(*m_range), std::end(*m_range), m_test}; }
+        iterator end() const { return {std::end(*m_range), std::end(*m_range), m_test}; }
+
+    private:
+
+        Range*                  m_range;
+        convertible_to_test<T>  m_test;
+    };
+
+
+    template <typename T>
+    struct of_type_fn
+    {
+        template <typename Range>
+        of_type_view<T, std::remove_reference_t<Range>> operator()(Range& range) const
+        {
+            return of_type_view<T, std::remove_reference_t<Range>>{range};
+        }
+
+        template <typename Range>
+        friend of_type_view<T, std::remove_reference_t<Range>> operator|(Range& range, of_type_fn)
+        {
+            return of_type_view<T, std::remove_reference_t<Range>>{range};
+        }
+    };
+
+}
+
+namespace views {
+
+    template <typename T>
+    constexpr type_hierarchy_detail::of_type_fn<T> of_type{};
+
+}
+
+}
@@ -0,0 +1,507 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+
+//!---------------------------------------------------------------------------------------------------------------------
+//!
+//!  \file
+//!
+//!  `ni::poly_collection<Root>` is a container for objects of types derived from a `type_hierarchy` type `Root`.
+//!  Instead of storing pointers to objects on the heap it stores the objects by value in one contiguous segment per
+//!  concrete type. Iterating with a matcher tests the type once per segment and runs one tight loop per segment
+//!  over all its objects, which allows the compiler to inline the lambda into the loop.
+//!
+//!  Example
+//!  ```
+//!  ni::poly_collection<Event> events;
+//!  events.reserve<MouseEvent>(1000);
+//!
+//!  events.emplace<MouseEvent>(13, 37);
+//!  events.emplace<KeyEvent>('k');
+//!
+//!  events.match
+//!  (   [](MouseEvent& m) { ... }     // invoked for all objects in segments of types derived from MouseEvent
+//!  ,   [](KeyEvent& k)   { ... }
+//!  ,   []                { ... }     // invoked for all other objects
+//!  );
+//!
+//!  for (Event& e : events) { ... }  // iterates segment by segment
+//!
+//!  events.erase_if([](Event const& e) { ... });   // removes objects and compacts the segments
+//!  ```
+//!
+//!  The order of objects is the insertion order within a segment, segments are ordered by their first insertion.
+//!  Inserting might relocate all objects of the same type, i.e. references to them are invalidated.
+//!
+//!---------------------------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <ni/type_hierarchy.h>
+#include <ni/type_hierarchy/id_map.h>
+#include <ni/functional/match.h>
+
+#include <boost/align/aligned_alloc.hpp>
+#include <boost/assert.hpp>
+
+#include <iterator>
+#include <new>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace ni {
+
+namespace type_hierarchy_detail {
+
+    using copy_construct_t = void (*)(void* dst, void const* src);
+
+    // type erased operations on the objects of one segment
+    struct segment_ops
+    {
+        void (*move_construct)(void* dst, void* src);
+        copy_construct_t copy_construct;
+        void (*destroy)(void* p);
+    };
+
+    template <typename T>
+    auto copy_construct_fn() -> std::enable_if_t<std::is_copy_constructible<T>::value, copy_construct_t>
+    {
+        return [](void* dst, void const* src) { ::new (dst) T(*static_cast<T const*>(src)); };
+    }
+
+    template <typename T>
+    auto copy_construct_fn() -> std::enable_if_t<not std::is_copy_constructible<T>::value, copy_construct_t>
+    {
+        return nullptr;
+    }
+
+    template <typename T>
+    segment_ops const* segment_ops_for()
+    {
+        static const segment_ops ops =
+        {   [](void* dst, void* src) { ::new (dst) T(std::move(*static_cast<T*>(src))); }
+        ,   copy_construct_fn<T>()
+        ,   [](void* p) { static_cast<T*>(p)->~T(); }
+        };
+        return &ops;
+    }
+
+
+    // the storage for all objects of one concrete type
+    template <typename Root>
+    class segment
+    {
+    public:
+
+        using id_t = typename get_config_t<Root>::id_t;
+
+        template <typename T>
+        static segment make()
+        {
+            return segment{id_of<T>::init(), sizeof(T), alignof(T), segment_ops_for<T>()};
+        }
+
+        segment(id_t id, std::size_t stride, std::size_t alignment, segment_ops const* ops)
+        :   m_id{id}, m_stride{stride}, m_alignment{alignment}, m_ops{ops}
+        {}
+
+        segment(segment&& other) noexcept
+        :   m_id{other.m_id}, m_stride{other.m_stride}, m_alignment{other.m_alignment}, m_ops{other.m_ops}
+        ,   m_root_offset{other.m_root_offset}
+        ,   m_data{std::exchange(other.m_data, nullptr)}
+        ,   m_size{std::exchange(other.m_size, 0)}
+        ,   m_capacity{std::exchange(other.m_capacity, 0)}
+        {}
+
+        segment(segment const& other)
+        :   m_id{other.m_id}, m_stride{other.m_stride}, m_alignment{other.m_alignment}, m_ops{other.m_ops}
+        ,   m_root_offset{other.m_root_offset}
+        {
+            BOOST_ASSERT_MSG( m_ops->copy_construct, "Type is not copy constructible." );
+            reserve(other.m_size);
+            for (; m_size < other.m_size; ++m_size)
+                m_ops->copy_construct(at(m_size), other.at(m_size));
+        }
+
+        segment& operator=(segment const&) = delete;
+        segment& operator=(segment&&) = delete;
+
+        ~segment()
+        {
+            clear();
+            boost::alignment::aligned_free(m_data);
+        }
+
+        id_t id() const { return m_id; }
+        std::size_t size() const { return m_size; }
+        std::size_t capacity() const { return m_capacity; }
+        std::size_t stride() const { return m_stride; }
+
+        void* at(std::size_t n) const { return m_data + n * m_stride; }
+        Root* root(std::size_t n) const { return reinterpret_cast<Root*>(m_data + n * m_stride + m_root_offset); }
+
+        // pointers to the Root sub-object of the first and behind the last object
+        char* root_begin() const { return m_data + m_root_offset; }
+        char* root_end() const { return m_data + m_size * m_stride + m_root_offset; }
+
+        void reserve(std::size_t capacity)
+        {
+            if (capacity <= m_capacity)
+                return;
+
+            auto* data = static_cast<char*>(boost::alignment::aligned_alloc(m_alignment, capacity * m_stride));
+            if (data == nullptr)
+                throw std::bad_alloc{};
+
+            for (std::size_t n = 0; n < m_size; ++n)
+            {
+                m_ops->move_construct(data + n * m_stride, at(n));
+                m_ops->destroy(at(n));
+            }
+            boost::alignment::aligned_free(m_data);
+            m_data = data;
+            m_capacity = capacity;
+        }
+
+        template <typename T, typename... Args>
+        T& emplace_back(Args&&... args)
+        {
+            if (m_size == m_capacity)
+                reserve(m_capacity ? 2 * m_capacity : 4);
+
+            T* t = ::new (at(m_size)) T(std::forward<Args>(args)...);
+            m_root_offset = reinterpret_cast<char*>(static_cast<Root*>(t)) - reinterpret_cast<char*>(t);
+            ++m_size;
+            return *t;
+        }
+
+        // moves the last object into the slot n
+        void erase_unordered(std::size_t n)
+        {
+            m_ops->destroy(at(n));
+            if (n + 1 != m_size)
+            {
+                m_ops->move_construct(at(n), at(m_size - 1));
+                m_ops->destroy(at(m_size - 1));
+            }
+            --m_size;
+        }
+
+        template <typename Predicate>
+        std::size_t erase_if(Predicate& pred)
+        {
+            std::size_t kept = 0;
+            for (std::size_t n = 0; n < m_size; ++n)
+            {
+                if (pred(*root(n)))
+                    m_ops->destroy(at(n));
+                else
+                {
+                    if (kept != n)
+                    {
+                        m_ops->move_construct(at(kept), at(n));
+                        m_ops->destroy(at(n));
+                    }
+                    ++kept;
+                }
+            }
+            auto const erased = m_size - kept;
+            m_size = kept;
+            return erased;
+        }
+
+        void clear()
+        {
+            for (std::size_t n = 0; n < m_size; ++n)
+                m_ops->destroy(at(n));
+            m_size = 0;
+        }
+
+    private:
+
+        id_t                m_id;
+        std::size_t         m_stride;
+        std::size_t         m_alignment;
+        segment_ops const*  m_ops;
+        std::ptrdiff_t      m_root_offset = 0;
+        char*               m_data = nullptr;
+        std::size_t         m_size = 0;
+        std::size_t         m_capacity = 0;
+    };
+
+
+    // invokes one case of a matcher on all objects of a segment
+    template <typename Root, typename... Lambdas>
+    struct segment_matcher
+    {
+        using cases_t = ni::detail::cases<Lambdas...>;
+        using function_t = void (*)(segment<Root> const&, Lambdas&...);
+
+        template <std::size_t K>
+        static void loop_case(segment<Root> const& s, Lambdas&... ls)
+        {
+            using target_t = typename cases_t::template target_t<K>;
+            auto& l = std::get<ni::detail::lambda_index_of_case<Lambdas...>(K)>(std::tie(ls...));
+            auto const stride = s.stride();
+            for (char* p = s.root_begin(), *end = s.root_end(); p != end; p += stride)
+                l(*ni::detail::case_cast(meta::try_t{}, ni::detail::target_type<target_t>{}, reinterpret_cast<Root*>(p)));
+        }
+
+        template <std::size_t D = cases_t::default_index>
+        static auto loop_default(segment<Root> const& s, Lambdas&... ls) -> std::enable_if_t<D < sizeof...(Lambdas)>
+        {
+            auto& l = std::get<D>(std::tie(ls...));
+            for (std::size_t n = 0; n < s.size(); ++n)
+                l();
+        }
+
+        template <std::size_t D = cases_t::default_index>
+        static auto loop_default(segment<Root> const&, Lambdas&...) -> std::enable_if_t<D == sizeof...(Lambdas)>
+        {}
+
+        template <std::size_t... Ks>
+        static void apply(std::index_sequence<Ks...>, segment<Root> const& s, Lambdas&... ls)
+        {
+            static constexpr function_t table[] = { &loop_case<Ks>..., &loop_default<> };
+            auto const k = ni::detail::case_index(meta::try_t{}, typename cases_t::target_list{}, s.root(0));
+            table[k](s, ls...);
+        }
+    };
+
+}
+
+
+template <typename Root>
+class poly_collection
+{
+    using config_t = type_hierarchy_detail::get_config_t<Root>;
+    using segment_t = type_hierarchy_detail::segment<Root>;
+
+    static_assert( not std::is_void<config_t>::value, "Root must be a type of a type_hierarchy." );
+
+public:
+
+    using id_t = typename config_t::id_t;
+    using value_type = Root;
+    using size_type = std::size_t;
+
+    template <typename Value>
+    class iterator_t
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::remove_const_t<Value>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Value*;
+        using reference = Value&;
+
+        iterator_t() = default;
+
+        template <typename Other, typename = std::enable_if_t<std::is_convertible<Other*, Value*>::value>>
+        iterator_t(iterator_t<Other> const& other) : m_segments{other.m_segments}, m_segment{other.m_segment}, m_index{other.m_index} {}
+
+        reference operator*() const { return *(*m_segments)[m_segment].root(m_index); }
+        pointer operator->() const { return (*m_segments)[m_segment].root(m_index); }
+
+        iterator_t& operator++()
+        {
+            ++m_index;
+            skip_empty();
+            return *this;
+        }
+
+        iterator_t operator++(int)
+        {
+            auto copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        friend bool operator==(iterator_t const& a, iterator_t const& b)
+        {
+            return a.m_segment == b.m_segment and a.m_index == b.m_index;
+        }
+
+        friend bool operator!=(iterator_t const& a, iterator_t const& b) { return not (a == b); }
+
+    private:
+        friend class poly_collection;
+        template <typename> friend class iterator_t;
+
+        iterator_t(std::vector<segment_t> const* segments, std::size_t segment, std::size_t index)
+        :   m_segments{segments}, m_segment{segment}, m_index{index}
+        {
+            skip_empty();
+        }
+
+        void skip_empty()
+        {
+            while (m_segment < m_segments->size() and m_index == (*m_segments)[m_segment].size())
+            {
+                ++m_segment;
+                m_index = 0;
+            }
+        }
+
+        std::vector<segment_t> const*  m_segments = nullptr;
+        std::size_t                    m_segment = 0;
+        std::size_t                    m_index = 0;
+    };
+
+    using iterator = iterator_t<Root>;
+    using const_iterator = iterator_t<Root const>;
+
+
+    poly_collection() = default;
+    poly_collection(poly_collection&&) = default;
+    poly_collection& operator=(poly_collection&&) = default;
+
+    poly_collection(poly_collection const& other)
+    :   m_segments{other.m_segments}
+    ,   m_index{other.m_index}
+    {}
+
+    poly_collection& operator=(poly_collection const& other)
+    {
+        if (this != &other)
+            *this = poly_collection{other};
+        return *this;
+    }
+
+
+    template <typename T, typename... Args>
+    T& emplace(Args&&... args)
+    {
+        return segment_of<T>().template emplace_back<T>(std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    std::decay_t<T>& insert(T&& x)
+    {
+        return emplace<std::decay_t<T>>(std::forward<T>(x));
+    }
+
+    //! Reserves storage for `capacity` objects of type T
+    template <typename T>
+    void reserve(std::size_t capacity)
+    {
+        segment_of<T>().reserve(capacity);
+    }
+
+    std::size_t size() const
+    {
+        std::size_t n = 0;
+        for (auto const& s : m_segments)
+            n += s.size();
+        return n;
+    }
+
+    template <typename T>
+    std::size_t size() const
+    {
+        auto const* s = find(type_hierarchy_detail::id_of<T>::init());
+        return s ? s->size() : 0;
+    }
+
+    template <typename T>
+    std::size_t capacity() const
+    {
+        auto const* s = find(type_hierarchy_detail::id_of<T>::init());
+        return s ? s->capacity() : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    iterator begin() { return {&m_segments, 0, 0}; }
+    iterator end() { return {&m_segments, m_segments.size(), 0}; }
+    const_iterator begin() const { return {&m_segments, 0, 0}; }
+    const_iterator end() const { return {&m_segments, m_segments.size(), 0}; }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    //! Removes the object at `pos` by moving the last object of the same type into its place. Returns the iterator
+    //! to the moved object or to the next object if `pos` was the last of its type.
+    iterator erase(const_iterator pos)
+    {
+        m_segments[pos.m_segment].erase_unordered(pos.m_index);
+        return {&m_segments, pos.m_segment, pos.m_index};
+    }
+
+    //! Removes all objects satisfying `pred` while keeping the order of the remaining ones.
+    template <typename Predicate>
+    std::size_t erase_if(Predicate pred)
+    {
+        std::size_t erased = 0;
+        for (auto& s : m_segments)
+            erased += s.erase_if(pred);
+        return erased;
+    }
+
+    void clear()
+    {
+        for (auto& s : m_segments)
+            s.clear();
+    }
+
+    //! Calls `f` on each object segment by segment.
+    template <typename Function>
+    void for_each(Function&& f)
+    {
+        for (auto& s : m_segments)
+            for (std::size_t n = 0; n < s.size(); ++n)
+                f(*s.root(n));
+    }
+
+    template <typename Function>
+    void for_each(Function&& f) const
+    {
+        for (auto const& s : m_segments)
+            for (std::size_t n = 0; n < s.size(); ++n)
+                f(static_cast<Root const&>(*s.root(n)));
+    }
+
+    //! Matches each object with the given lambdas like `ni::match` does. The case is selected once per segment.
+    template <typename... Lambdas>
+    void match(Lambdas&&... lambdas)
+    {
+        using matcher_t = type_hierarchy_detail::segment_matcher<Root, std::remove_reference_t<Lambdas>...>;
+        for (auto const& s : m_segments)
+            if (s.size() > 0)
+                matcher_t::apply(std::make_index_sequence<matcher_t::cases_t::size>{}, s, lambdas...);
+    }
+
+private:
+
+    template <typename T>
+    segment_t& segment_of()
+    {
+        static_assert( std::is_base_of<Root, T>::value, "T must be derived from Root." );
+
+        auto const id = type_hierarchy_detail::id_of<T>::init();
+        if (auto* index = m_index.find(id))
+            return m_segments[*index];
+
+        m_segments.push_back(segment_t::template make<T>());
+        m_index.insert(id, m_segments.size() - 1);
+        return m_segments.back();
+    }
+
+    segment_t const* find(id_t id) const
+    {
+        auto const* index = m_index.find(id);
+        return index ? &m_segments[*index] : nullptr;
+    }
+
+    std::vector<segment_t>                                  m_segments;
+    type_hierarchy_detail::id_map<id_t, std::size_t>        m_index;
+};
+
+}
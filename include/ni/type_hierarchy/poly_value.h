@@ -0,0 +1,295 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+
+//!---------------------------------------------------------------------------------------------------------------------
+//!
+//!  \file
+//!
+//!  `ni::poly_value<Root, Capacity>` holds one object of any type derived from the `type_hierarchy` type `Root` in
+//!  an inline buffer of `Capacity` bytes. It has value semantics: copying the value copies the object, and nothing
+//!  is allocated on the heap. Types that don't fit into the buffer are rejected at compile time.
+//!
+//!  Example
+//!  ```
+//!  using event_value = ni::poly_value<Event, 32>;
+//!
+//!  std::vector<event_value> events;
+//!  events.emplace_back(MouseEvent{13, 37});
+//!  events.emplace_back(KeyEvent{'k'});
+//!
+//!  for (auto const& e : events)
+//!      ni::match(e)
+//!      (   [](MouseEvent const& m) { ... }
+//!      ,   [](KeyEvent const& k)   { ... }
+//!      );
+//!
+//!  Event& e = *events[0];
+//!  ```
+//!
+//!  By default the object is copied, moved and destroyed via the operations of its type, which have to be nothrow
+//!  move constructible, so that vectors of values move their elements when they grow. If all types that will be
+//!  stored are trivially copyable, `ni::poly_value<Root, Capacity, ni::type_hierarchy::trivial_copy>` is trivially
+//!  copyable itself, i.e. it's copied with `memcpy` and vectors relocate their elements with `memmove`.
+//!
+//!  Moving a value leaves the source empty. Copying a value holding a type that is not copy constructible asserts.
+//!
+//!---------------------------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <ni/type_hierarchy.h>
+#include <ni/meta/type_list.h>
+
+#include <boost/assert.hpp>
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace ni {
+
+namespace type_hierarchy {
+
+    //! The object is copied, moved and destroyed via the operations of its type
+    struct erased_copy {};
+
+    //! All stored types are trivially copyable, the value is trivially copyable as well
+    struct trivial_copy {};
+
+}
+
+namespace type_hierarchy_detail {
+
+    // type erased operations on the object of a poly_value
+    struct value_ops
+    {
+        std::ptrdiff_t  root_offset;
+        void            (*move_construct)(void* dst, void* src);
+        void            (*copy_construct)(void* dst, void const* src);
+        void            (*destroy)(void* p);
+    };
+
+    template <typename T>
+    auto value_copy_fn() -> std::enable_if_t<std::is_copy_constructible<T>::value, void (*)(void*, void const*)>
+    {
+        return [](void* dst, void const* src) { ::new (dst) T(*static_cast<T const*>(src)); };
+    }
+
+    template <typename T>
+    auto value_copy_fn() -> std::enable_if_t<not std::is_copy_constructible<T>::value, void (*)(void*, void const*)>
+    {
+        return nullptr;
+    }
+
+    template <typename Root, typename T>
+    value_ops const* value_ops_for(T* p)
+    {
+        static const value_ops ops =
+        {   reinterpret_cast<char*>(static_cast<Root*>(p)) - reinterpret_cast<char*>(p)
+        ,   [](void* dst, void* src) { ::new (dst) T(std::move(*static_cast<T*>(src))); }
+        ,   value_copy_fn<T>()
+        ,   [](void* p) { static_cast<T*>(p)->~T(); }
+        };
+        return &ops;
+    }
+
+
+    // the buffer and the special members of poly_value, trivial for trivial_copy
+    template <std::size_t Capacity, typename Copy>
+    class value_storage;
+
+    template <std::size_t Capacity>
+    class value_storage<Capacity, type_hierarchy::erased_copy>
+    {
+    protected:
+
+        value_storage() noexcept = default;
+
+        value_storage(value_storage const& other)
+        {
+            copy_from(other);
+        }
+
+        value_storage(value_storage&& other) noexcept
+        {
+            move_from(other);
+        }
+
+        value_storage& operator=(value_storage const& other)
+        {
+            if (this != &other)
+            {
+                reset();
+                copy_from(other);
+            }
+            return *this;
+        }
+
+        value_storage& operator=(value_storage&& other) noexcept
+        {
+            if (this != &other)
+            {
+                reset();
+                move_from(other);
+            }
+            return *this;
+        }
+
+        ~value_storage()
+        {
+            reset();
+        }
+
+        void reset() noexcept
+        {
+            if (m_ops)
+            {
+                m_ops->destroy(&m_buffer);
+                m_ops = nullptr;
+            }
+        }
+
+        value_ops const*  m_ops = nullptr;
+        std::aligned_storage_t<Capacity, alignof(std::max_align_t)>  m_buffer;
+
+    private:
+
+        void copy_from(value_storage const& other)
+        {
+            if (other.m_ops == nullptr)
+                return;
+
+            BOOST_ASSERT_MSG( other.m_ops->copy_construct, "Type is not copy constructible." );
+            other.m_ops->copy_construct(&m_buffer, &other.m_buffer);
+            m_ops = other.m_ops;
+        }
+
+        void move_from(value_storage& other) noexcept
+        {
+            if (other.m_ops == nullptr)
+                return;
+
+            other.m_ops->move_construct(&m_buffer, &other.m_buffer);
+            m_ops = other.m_ops;
+            other.reset();
+        }
+    };
+
+    template <std::size_t Capacity>
+    class value_storage<Capacity, type_hierarchy::trivial_copy>
+    {
+    protected:
+
+        void reset() noexcept
+        {
+            m_ops = nullptr;
+        }
+
+        value_ops const*  m_ops = nullptr;
+        std::aligned_storage_t<Capacity, alignof(std::max_align_t)>  m_buffer;
+    };
+
+}
+
+
+template <typename Root, std::size_t Capacity, typename Copy = type_hierarchy::erased_copy>
+class poly_value : private type_hierarchy_detail::value_storage<Capacity, Copy>
+{
+    using storage_t = type_hierarchy_detail::value_storage<Capacity, Copy>;
+
+    static_assert( not std::is_void<type_hierarchy_detail::get_config_t<Root>>::value
+                 , "Root must be a type of a type_hierarchy."
+                 );
+
+    template <typename T>
+    using enable_if_object_t = std::enable_if_t<std::is_base_of<Root, std::decay_t<T>>::value>;
+
+public:
+
+    static constexpr std::size_t capacity = Capacity;
+
+    poly_value() noexcept = default;
+
+    //! Stores a copy of x
+    template <typename T, typename = enable_if_object_t<T>>
+    poly_value(T&& x)
+    {
+        emplace<std::decay_t<T>>(std::forward<T>(x));
+    }
+
+    //! Destroys the current object and constructs an object of type T in place
+    template <typename T, typename... Args>
+    T& emplace(Args&&... args)
+    {
+        static_assert( std::is_base_of<Root, T>::value, "T must be derived from Root." );
+        static_assert( sizeof(T) <= Capacity, "T does not fit into the buffer of the poly_value." );
+        static_assert( alignof(T) <= alignof(std::max_align_t), "T is over-aligned for the buffer of the poly_value." );
+        static_assert( std::is_same<Copy, type_hierarchy::erased_copy>::value or std::is_trivially_copyable<T>::value
+                     , "T must be trivially copyable to be stored in a poly_value with trivial_copy."
+                     );
+        static_assert( std::is_nothrow_move_constructible<T>::value, "T must be nothrow move constructible." );
+
+        reset();
+        T* p = ::new (&this->m_buffer) T(std::forward<Args>(args)...);
+        this->m_ops = type_hierarchy_detail::value_ops_for<Root>(p);
+        return *p;
+    }
+
+    //! Destroys the object, the value is empty afterwards
+    void reset() noexcept
+    {
+        storage_t::reset();
+    }
+
+    bool has_value() const noexcept { return this->m_ops != nullptr; }
+    explicit operator bool() const noexcept { return has_value(); }
+
+    //! The object, nullptr if the value is empty
+    Root* get() noexcept
+    {
+        return this->m_ops ? reinterpret_cast<Root*>(reinterpret_cast<char*>(&this->m_buffer) + this->m_ops->root_offset) : nullptr;
+    }
+
+    Root const* get() const noexcept
+    {
+        return const_cast<poly_value*>(this)->get();
+    }
+
+    Root& operator*() noexcept { return *get(); }
+    Root const& operator*() const noexcept { return *get(); }
+    Root* operator->() noexcept { return get(); }
+    Root const* operator->() const noexcept { return get(); }
+};
+
+
+// dyn_cast<> & dyn_case() are the hooks for ni::match, they forward to the object
+
+template <typename TargetType, typename Root, std::size_t Capacity, typename Copy>
+auto dyn_cast(poly_value<Root, Capacity, Copy>* p)
+{
+    return p->has_value() ? type_hierarchy_detail::dyn_cast<TargetType>(p->get()) : nullptr;
+}
+
+template <typename TargetType, typename Root, std::size_t Capacity, typename Copy>
+auto dyn_cast(poly_value<Root, Capacity, Copy> const* p)
+{
+    return p->has_value() ? type_hierarchy_detail::dyn_cast<TargetType>(p->get()) : nullptr;
+}
+
+template <typename... Targets, typename Root, std::size_t Capacity, typename Copy>
+auto dyn_case(meta::type_list<Targets...> targets, poly_value<Root, Capacity, Copy> const* p)
+-> decltype(type_hierarchy_detail::dyn_case(targets, p->get()))
+{
+    return p->has_value() ? type_hierarchy_detail::dyn_case(targets, p->get()) : sizeof...(Targets);
+}
+
+}
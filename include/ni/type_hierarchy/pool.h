@@ -0,0 +1,284 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+
+//!---------------------------------------------------------------------------------------------------------------------
+//!
+//!  \file
+//!
+//!  `ni::type_hierarchy::pool` is an object pool for types of a `type_hierarchy`. It keeps one slab of fixed size
+//!  slots per concrete type. All memory is allocated upfront by `reserve`, creating and destroying objects afterwards
+//!  is lock-free and never calls into the system allocator, which makes it usable on real-time threads. Since all
+//!  objects of one type live in the same slab they stay close to each other in memory.
+//!
+//!  Example
+//!  ```
+//!  ni::type_hierarchy::pool<Event> pool;
+//!
+//!  // at startup
+//!  pool.reserve<MouseEvent>(1024);
+//!  pool.reserve<KeyEvent>(256);
+//!
+//!  // on the real-time thread
+//!  Event* e = pool.create<MouseEvent>(13, 37);     // nullptr if all slots are in use
+//!  ...
+//!  pool.destroy(e);                                 // finds the slab via the id of the object
+//!
+//!  auto o = pool.occupancy<MouseEvent>();           // o.capacity, o.used, o.peak
+//!  ```
+//!
+//!  `reserve` must not run concurrently with any other member function. `create` and `destroy` can be called
+//!  concurrently from any thread.
+//!
+//!---------------------------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <ni/type_hierarchy.h>
+#include <ni/type_hierarchy/id_map.h>
+
+#include <boost/align/aligned_alloc.hpp>
+#include <boost/assert.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace ni {
+
+namespace type_hierarchy_detail {
+
+    // A fixed number of slots for objects of one type with a lock-free free list. The free list is a stack of slot
+    // indices. The head stores the index in the lower and an ABA counter in the upper 32 bits.
+    class slab
+    {
+    public:
+
+        static constexpr std::uint32_t npos = ~std::uint32_t(0);
+
+        slab(std::size_t capacity, std::size_t slot_size, std::size_t alignment)
+        :   m_storage{ capacity > 0
+                     ? static_cast<char*>(boost::alignment::aligned_alloc(alignment, capacity * slot_size))
+                     : nullptr
+                     }
+        ,   m_next{new std::atomic<std::uint32_t>[capacity]}
+        ,   m_capacity{capacity}
+        ,   m_slot_size{slot_size}
+        {
+            BOOST_ASSERT_MSG( capacity < npos, "Capacity of slab exceeded." );
+            if (capacity > 0 and not m_storage)
+                throw std::bad_alloc{};
+
+            for (std::size_t n = 0; n < capacity; ++n)
+                m_next[n].store(n + 1 < capacity ? std::uint32_t(n + 1) : npos, std::memory_order_relaxed);
+            m_head.store(capacity > 0 ? 0 : npos, std::memory_order_release);
+        }
+
+        ~slab()
+        {
+            BOOST_ASSERT_MSG( used() == 0, "Pool destroyed while objects are still alive." );
+            boost::alignment::aligned_free(m_storage);
+        }
+
+        slab(slab const&) = delete;
+        slab& operator=(slab const&) = delete;
+
+        void* pop() noexcept
+        {
+            auto head = m_head.load(std::memory_order_acquire);
+            for (;;)
+            {
+                auto const index = std::uint32_t(head);
+                if (index == npos)
+                    return nullptr;
+                auto const next = m_next[index].load(std::memory_order_relaxed);
+                auto const new_head = ((head >> 32) + 1) << 32 | next;
+                if (m_head.compare_exchange_weak(head, new_head, std::memory_order_acquire, std::memory_order_acquire))
+                    break;
+            }
+
+            auto const used = m_used.fetch_add(1, std::memory_order_relaxed) + 1;
+            auto peak = m_peak.load(std::memory_order_relaxed);
+            while (peak < used and not m_peak.compare_exchange_weak(peak, used, std::memory_order_relaxed)) {}
+
+            return m_storage + std::uint32_t(head) * m_slot_size;
+        }
+
+        void push(void* p) noexcept
+        {
+            BOOST_ASSERT_MSG( owns(p), "Object does not belong to this pool." );
+            auto const index = std::uint32_t((static_cast<char*>(p) - m_storage) / m_slot_size);
+            auto head = m_head.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                m_next[index].store(std::uint32_t(head), std::memory_order_relaxed);
+                auto const new_head = ((head >> 32) + 1) << 32 | index;
+                if (m_head.compare_exchange_weak(head, new_head, std::memory_order_release, std::memory_order_relaxed))
+                    break;
+            }
+            m_used.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        bool owns(void const* p) const noexcept
+        {
+            auto const* c = static_cast<char const*>(p);
+            return m_storage <= c and c < m_storage + m_capacity * m_slot_size;
+        }
+
+        std::size_t capacity() const noexcept { return m_capacity; }
+        std::size_t used() const noexcept { return m_used.load(std::memory_order_relaxed); }
+        std::size_t peak() const noexcept { return m_peak.load(std::memory_order_relaxed); }
+
+    private:
+
+        char*                                         m_storage;
+        std::unique_ptr<std::atomic<std::uint32_t>[]> m_next;
+        std::size_t                                   m_capacity;
+        std::size_t                                   m_slot_size;
+        std::atomic<std::uint64_t>                    m_head{npos};
+        std::atomic<std::size_t>                      m_used{0};
+        std::atomic<std::size_t>                      m_peak{0};
+    };
+
+}
+
+namespace type_hierarchy {
+
+    template <typename Root>
+    class pool
+    {
+        using config_t = type_hierarchy_detail::get_config_t<Root>;
+        static_assert( not std::is_void<config_t>::value, "Root must be a type of a type_hierarchy." );
+
+    public:
+
+        using id_t = typename config_t::id_t;
+
+        struct occupancy_t
+        {
+            id_t         id;
+            std::size_t  capacity;
+            std::size_t  used;
+            std::size_t  peak;
+        };
+
+        pool() = default;
+        pool(pool const&) = delete;
+        pool& operator=(pool const&) = delete;
+
+        //! Allocates the slab for `capacity` objects of type T. Must be called at most once per type.
+        template <typename T>
+        void reserve(std::size_t capacity)
+        {
+            static_assert( std::is_base_of<Root, T>::value, "T must be derived from Root." );
+
+            auto const id = type_hierarchy_detail::id_of<T>::init();
+            BOOST_ASSERT_MSG( find(id) == nullptr, "Type has already been reserved." );
+
+            m_slabs.push_back(std::make_unique<slab_t>(id, capacity, sizeof(T), alignof(T), &destruct<T>));
+            m_index.insert(id, m_slabs.back().get());
+        }
+
+        //! Constructs an object of type T, returns nullptr if the slab of T is exhausted or not reserved.
+        template <typename T, typename... Args>
+        T* create(Args&&... args)
+        {
+            auto* s = find(type_hierarchy_detail::id_of<T>::init());
+            if (s == nullptr)
+                return nullptr;
+
+            void* p = s->pop();
+            if (p == nullptr)
+                return nullptr;
+
+            try
+            {
+                return ::new (p) T(std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                s->push(p);
+                throw;
+            }
+        }
+
+        //! Destroys an object that has been created by this pool.
+        void destroy(Root const* p)
+        {
+            if (p == nullptr)
+                return;
+
+            auto* s = find(p->type_hierarchy_id__());
+            BOOST_ASSERT_MSG( s != nullptr, "Object does not belong to this pool." );
+            s->push(s->destruct(const_cast<Root*>(p)));
+        }
+
+        template <typename T>
+        occupancy_t occupancy() const
+        {
+            return occupancy(type_hierarchy_detail::id_of<T>::init());
+        }
+
+        occupancy_t occupancy(id_t id) const
+        {
+            auto const* s = find(id);
+            return s ? occupancy_t{id, s->capacity(), s->used(), s->peak()} : occupancy_t{id, 0, 0, 0};
+        }
+
+        //! The occupancy of all reserved types in the order of reservation.
+        std::vector<occupancy_t> occupancies() const
+        {
+            std::vector<occupancy_t> result;
+            result.reserve(m_slabs.size());
+            for (auto const& s : m_slabs)
+                result.push_back({s->id, s->capacity(), s->used(), s->peak()});
+            return result;
+        }
+
+    private:
+
+        struct slab_t : type_hierarchy_detail::slab
+        {
+            using destruct_t = void* (*)(Root*);
+
+            slab_t(id_t id_, std::size_t capacity, std::size_t size, std::size_t alignment, destruct_t destruct_)
+            :   slab{capacity, size, alignment}
+            ,   id{id_}
+            ,   destruct{destruct_}
+            {}
+
+            id_t        id;
+            destruct_t  destruct;
+        };
+
+        template <typename T>
+        static void* destruct(Root* p)
+        {
+            T* t = static_cast<T*>(p);
+            t->~T();
+            return t;
+        }
+
+        slab_t* find(id_t id) const
+        {
+            auto const* s = m_index.find(id);
+            return s ? *s : nullptr;
+        }
+
+        std::vector<std::unique_ptr<slab_t>>          m_slabs;
+        type_hierarchy_detail::id_map<id_t, slab_t*>  m_index;
+    };
+
+}
+
+}
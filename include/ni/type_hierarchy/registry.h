@@ -0,0 +1,201 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+
+//!---------------------------------------------------------------------------------------------------------------------
+//!
+//!  \file
+//!
+//!  `ni::type_hierarchy::registry<Root>` gives access to the types of a hierarchy at runtime: their ids, names,
+//!  sizes, alignments, super types and how many ids are used on each level. This allows to size tables, pools or
+//!  per-type metrics at startup.
+//!
+//!  The registry is opt-in per hierarchy. The user defined base has to declare the alias `type_hierarchy_registry`:
+//!  ```
+//!  #include <ni/type_hierarchy/registry.h>
+//!
+//!  struct EventBase
+//!  {
+//!      using type_hierarchy_registry = ni::type_hierarchy::enable_registry;
+//!  };
+//!
+//!  using Event = ni::type_hierarchy::from_base<EventBase>;
+//!  struct MouseEvent : ni::sub_type<MouseEvent, Event> {};
+//!
+//!  for (auto const& t : ni::type_hierarchy::registry<Event>::types())
+//!      std::cout << t.name << " " << t.size << "\n";
+//!
+//!  auto const* t = ni::type_hierarchy::registry<Event>::find(e.type_hierarchy_id__());
+//!  ```
+//!
+//!  Types are registered during static initialization, all types that are constructed anywhere in the program are
+//!  registered before `main` is entered. Hierarchies without the alias don't register anything and don't pay for it.
+//!  The root itself is not registered, its id is 0.
+//!
+//!  Types of plugins are added when the plugin is loaded and removed when it's unloaded. Plugins can be loaded
+//!  concurrently, but the functions of the registry must not run concurrently with loading or unloading plugins.
+//!
+//!---------------------------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <ni/type_hierarchy.h>
+#include <ni/type_hierarchy/id_map.h>
+
+#include <boost/utility/string_view.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace ni {
+
+namespace type_hierarchy {
+
+    //! Declare `using type_hierarchy_registry = enable_registry;` in the user defined base to enable the registry.
+    struct enable_registry {};
+
+    template <typename Id>
+    struct type_entry
+    {
+        Id                  id;
+        Id                  parent_id;      // 0 for the types on level 1
+        int                 level;
+        std::size_t         size;
+        std::size_t         alignment;
+        boost::string_view  name;
+    };
+
+    struct level_usage
+    {
+        int            bits;            // bits of the id used by the level
+        std::size_t    types;           // number of registered types on the level
+        std::uint64_t  max_local_id;    // the highest id that has been assigned on the level
+    };
+
+}
+
+namespace type_hierarchy_detail {
+
+    template <typename Config>
+    struct type_registry
+    {
+        using id_t = typename Config::id_t;
+        using entry_t = type_hierarchy::type_entry<id_t>;
+
+        static type_registry& instance()
+        {
+            static type_registry registry;
+            return registry;
+        }
+
+        template <typename Derived, typename SuperType>
+        static id_t add()
+        {
+            auto& r = instance();
+            auto const id = id_of<Derived>::init();
+
+            std::lock_guard<std::mutex> lock{r.mutex};
+            BOOST_ASSERT_MSG( r.index.find(id) == nullptr, "Type has already been registered." );
+
+            r.index.insert(id, r.types.size());
+            r.types.push_back(
+            {   id
+            ,   static_cast<id_t>(super_id_value<SuperType>::type::init())
+            ,   level_of_v<SuperType> + 1
+            ,   sizeof(Derived)
+            ,   alignof(Derived)
+            ,   string_view_of(type_name<Derived>())
+            });
+            return id;
+        }
+
+        static void remove(id_t id)
+        {
+            auto& r = instance();
+            std::lock_guard<std::mutex> lock{r.mutex};
+
+            auto const* index = r.index.find(id);
+            BOOST_ASSERT_MSG( index != nullptr, "Type has not been registered." );
+            r.types.erase(r.types.begin() + std::ptrdiff_t(*index));
+
+            r.index.clear();
+            for (std::size_t i = 0; i < r.types.size(); ++i)
+                r.index.insert(r.types[i].id, i);
+        }
+
+        static boost::string_view string_view_of(type_name_t name)
+        {
+            return {name.data, name.size};
+        }
+
+        std::mutex                 mutex;
+        std::vector<entry_t>       types;
+        id_map<id_t, std::size_t>  index;
+    };
+
+}
+
+namespace type_hierarchy {
+
+    template <typename Root>
+    class registry
+    {
+        using config_t = type_hierarchy_detail::get_config_t<Root>;
+        using registry_t = type_hierarchy_detail::type_registry<config_t>;
+
+        static_assert( type_hierarchy_detail::registry_enabled<typename config_t::base_type>::value
+                     , "The registry is not enabled for the hierarchy, see enable_registry."
+                     );
+
+    public:
+
+        using id_t = typename config_t::id_t;
+        using entry_t = type_entry<id_t>;
+
+        static constexpr int num_levels = int(typename config_t::bits_per_level{}.size());
+
+        //! All registered types in the order of registration
+        static std::vector<entry_t> const& types()
+        {
+            return registry_t::instance().types;
+        }
+
+        //! The type with the given id, nullptr if there is none
+        static entry_t const* find(id_t id)
+        {
+            auto const& r = registry_t::instance();
+            auto const* index = r.index.find(id);
+            return index ? &r.types[*index] : nullptr;
+        }
+
+        //! The usage of the ids of each level, index 0 is level 1
+        static std::vector<level_usage> levels()
+        {
+            std::vector<level_usage> result;
+            for (int level = 0; level < num_levels; ++level)
+                result.push_back({type_hierarchy_detail::get_at(typename config_t::bits_per_level{}, level), 0, 0});
+
+            for (auto const& t : types())
+            {
+                auto& usage = result[std::size_t(t.level - 1)];
+                auto const shift = type_hierarchy_detail::get_at(typename config_t::level_shifts{}, t.level - 1);
+                auto const local_id = std::uint64_t(t.id >> shift) & type_hierarchy_detail::low_bits<std::uint64_t>(usage.bits);
+                ++usage.types;
+                usage.max_local_id = local_id > usage.max_local_id ? local_id : usage.max_local_id;
+            }
+            return result;
+        }
+    };
+
+}
+
+}
@@ -0,0 +1,35 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+
+//!---------------------------------------------------------------------------------------------------------------------
+//!
+//!  \file
+//!
+//!  Detects the SIMD instruction sets the `type_hierarchy` kernels may use. `NI_TYPE_HIERARCHY_SSE2` and
+//!  `NI_TYPE_HIERARCHY_AVX2` are defined if the compiler targets them, e.g. with `-mavx2`. Define
+//!  `NI_TYPE_HIERARCHY_NO_SIMD` to always use scalar code.
+//!
+//!---------------------------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#if not defined(NI_TYPE_HIERARCHY_NO_SIMD)
+    #if defined(__AVX2__)
+        #define NI_TYPE_HIERARCHY_AVX2 1
+    #endif
+    #if defined(__SSE2__) or defined(_M_X64) or (defined(_M_IX86_FP) and _M_IX86_FP >= 2)
+        #define NI_TYPE_HIERARCHY_SSE2 1
+    #endif
+#endif
+
+#if defined(NI_TYPE_HIERARCHY_SSE2) or defined(NI_TYPE_HIERARCHY_AVX2)
+    #include <immintrin.h>
+#endif
@@ -0,0 +1,208 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+
+//!---------------------------------------------------------------------------------------------------------------------
+//!
+//!  \file
+//!
+//!  `ni::type_hierarchy::tagged_ptr<Root>` is a non-owning pointer to an object of a `type_hierarchy` that stores
+//!  the id of the object in the unused high bits of the address. `ni::match` and `ni::convertible_to` decide on the
+//!  handle without loading the object, only the selected case touches it. Vectors of handles can be filtered by
+//!  type without a single access to the objects. Only tests for interfaces (see type_hierarchy.h) read the object.
+//!
+//!  Example
+//!  ```
+//!  using Event = ni::type_hierarchy::from_base<EventBase, 4, 4, 4, 4>;   // 16 bits
+//!
+//!  std::vector<ni::type_hierarchy::tagged_ptr<Event>> events = …;
+//!
+//!  for (auto e : events)
+//!      ni::match(e)
+//!      (   [](MouseEvent& e) { … }
+//!      ,   [](KeyEvent& e)   { … }
+//!      );
+//!
+//!  auto n = std::count_if(events.begin(), events.end(), [](auto e) { return ni::convertible_to<KeyEvent>(e); });
+//!  ```
+//!
+//!  The id is read once when the handle is created. Ids of all bits per level together must fit into the bits above
+//!  the address, which are 16 bits on common 64 bit platforms. Define `NI_TYPE_HIERARCHY_ADDRESS_BITS` if the
+//!  platform uses more than 48 bits for user space addresses.
+//!
+//!---------------------------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <ni/type_hierarchy.h>
+#include <ni/meta/fold_add.h>
+#include <ni/meta/type_list.h>
+
+#include <boost/assert.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if not defined(NI_TYPE_HIERARCHY_ADDRESS_BITS)
+    #define NI_TYPE_HIERARCHY_ADDRESS_BITS 48
+#endif
+
+namespace ni {
+
+namespace type_hierarchy_detail {
+
+    template <int... Ns>
+    constexpr int total_bits(std::integer_sequence<int, Ns...>)
+    {
+        return meta::fold_add_v<int, Ns...>;
+    }
+
+    template <typename Root>
+    class tagged_ptr
+    {
+        using config_t = get_config_t<Root>;
+
+        static_assert( not std::is_void<config_t>::value, "Root must be a type of a type_hierarchy." );
+        static_assert( sizeof(std::uintptr_t) == 8, "Tagged pointers require 64 bit addresses." );
+
+        static constexpr int address_bits = NI_TYPE_HIERARCHY_ADDRESS_BITS;
+        static constexpr std::uintptr_t address_mask = (std::uintptr_t(1) << address_bits) - 1;
+
+        static_assert( total_bits(typename config_t::bits_per_level{}) <= 64 - address_bits
+                     , "The ids of the hierarchy don't fit into the spare bits of a pointer."
+                     );
+
+        template <typename> friend class tagged_ptr;
+
+    public:
+
+        using element_type = Root;
+        using id_t = typename config_t::id_t;
+
+        tagged_ptr() noexcept = default;
+        tagged_ptr(std::nullptr_t) noexcept {}
+
+        template <typename T, typename = std::enable_if_t<std::is_convertible<T*, Root*>::value>>
+        tagged_ptr(T* p) : tagged_ptr{static_cast<Root*>(p), p ? id_of_object(*p) : id_t{0}} {}
+
+        template <typename T, typename = std::enable_if_t<std::is_convertible<T*, Root*>::value>>
+        tagged_ptr(tagged_ptr<T> const& other) noexcept
+        :   m_bits{reinterpret_cast<std::uintptr_t>(static_cast<Root*>(other.get())) | (other.m_bits & ~address_mask)}
+        {}
+
+        Root* get() const noexcept { return reinterpret_cast<Root*>(m_bits & address_mask); }
+        Root& operator*() const noexcept { return *get(); }
+        Root* operator->() const noexcept { return get(); }
+
+        //! The id of the object, 0 for null pointers
+        id_t id() const noexcept { return static_cast<id_t>(m_bits >> address_bits); }
+
+        explicit operator bool() const noexcept { return (m_bits & address_mask) != 0; }
+
+        friend bool operator==(tagged_ptr const& a, tagged_ptr const& b) noexcept { return a.m_bits == b.m_bits; }
+        friend bool operator!=(tagged_ptr const& a, tagged_ptr const& b) noexcept { return a.m_bits != b.m_bits; }
+
+    private:
+
+        template <typename T>
+        static id_t id_of_object(T const& x)
+        {
+            return static_cast<id_holder<config_t> const&>(x).type_hierarchy_id__();
+        }
+
+        tagged_ptr(Root* p, id_t id)
+        :   m_bits{reinterpret_cast<std::uintptr_t>(p) | (std::uintptr_t(id) << address_bits)}
+        {
+            BOOST_ASSERT_MSG( (reinterpret_cast<std::uintptr_t>(p) & ~address_mask) == 0
+                            , "Address does not fit into the address bits of a tagged pointer."
+                            );
+        }
+
+        std::uintptr_t m_bits = 0;
+    };
+
+
+    template <typename TargetType, typename Root>
+    bool convertible_to_handle(std::false_type /* is interface */, tagged_ptr<Root> const& p)
+    {
+        using config_t = get_config_t<Root>;
+        return convertible_to_impl<TargetType, get_config_t<TargetType>, config_t>::apply(p.id());
+    }
+
+    // the interfaces are not part of the id, they are read from the object
+    template <typename TargetType, typename Root>
+    bool convertible_to_handle(std::true_type, tagged_ptr<Root> const& p)
+    {
+        return convertible_to<TargetType>(*p);
+    }
+
+    template <typename TargetType, typename Root>
+    bool convertible_to(tagged_ptr<Root> const& p)
+    {
+        using is_interface_t = is_interface_of<get_config_t<Root>, std::remove_cv_t<TargetType>>;
+        return p and convertible_to_handle<TargetType>(is_interface_t{}, p);
+    }
+
+
+    // dyn_cast<> & dyn_case() are the hooks for ni::match, they only look at the id of the handle,
+    // except for interfaces
+
+    template <typename TargetType, typename Root>
+    cast_result_t<TargetType, Root> tagged_cast(up_cast, tagged_ptr<Root> const& p)
+    {
+        return p.get();
+    }
+
+    template <typename TargetType, typename Root>
+    cast_result_t<TargetType, Root> tagged_cast(down_cast, tagged_ptr<Root> const& p)
+    {
+        return convertible_to<TargetType>(p) ? static_cast<cast_result_t<TargetType, Root>>(p.get()) : nullptr;
+    }
+
+    template <typename TargetType, typename Root>
+    cast_result_t<TargetType, Root> tagged_cast(cross_cast, tagged_ptr<Root> const&)
+    {
+        return nullptr;
+    }
+
+    template <typename TargetType, typename Root>
+    cast_result_t<TargetType, Root> tagged_cast(interface_cast, tagged_ptr<Root> const& p)
+    {
+        return p ? dyn_cast<TargetType>(p.get()) : nullptr;
+    }
+
+    template <typename TargetType, typename Root>
+    cast_result_t<TargetType, Root> dyn_cast(tagged_ptr<Root> const* p)
+    {
+        return tagged_cast<TargetType>(cast_kind_t<TargetType, std::remove_cv_t<Root>>{}, *p);
+    }
+
+    template <typename... Targets, typename Root>
+    auto dyn_case(meta::type_list<Targets...>, tagged_ptr<Root> const* p)
+    -> std::enable_if_t<case_table_traits<get_config_t<Root>, std::remove_cv_t<Targets>...>::enabled, std::size_t>
+    {
+        static const auto table = make_case_table<get_config_t<Root>, std::remove_cv_t<Targets>...>();
+        return *p ? table.lookup(p->id()) : sizeof...(Targets);
+    }
+
+}
+
+namespace type_hierarchy {
+
+    using type_hierarchy_detail::tagged_ptr;
+
+    // the overloads for tagged pointers have to be added to the using declarations
+    using type_hierarchy_detail::convertible_to;
+}
+
+using type_hierarchy::convertible_to;
+
+}
@@ -0,0 +1,233 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+
+//!---------------------------------------------------------------------------------------------------------------------
+//!
+//!  \file
+//!
+//!  `wide_id<Words>` is the id type of hierarchies whose bits per level add up to more than 64 bits. It's an
+//!  unsigned integer of `Words` 64 bit words with the bitwise operators and shifts the `type_hierarchy` needs, all
+//!  of them usable in constant expressions, so static ids work as before.
+//!
+//!  The test of `convertible_to`, `(id & mask) == value`, is done with SSE2 on 128 bits at once, or with AVX2 on 256
+//!  bits at once if the id has a multiple of 4 words. It's branch free and takes constant time for any id.
+//!
+//!---------------------------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <ni/type_hierarchy/simd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace ni {
+
+namespace type_hierarchy_detail {
+
+    template <std::size_t Words>
+    struct alignas(16) wide_id
+    {
+        static_assert( Words > 0 and Words % 2 == 0, "Wide ids must have an even number of words." );
+
+        // words[0] holds the lowest bits
+        std::uint64_t words[Words];
+
+        constexpr wide_id() noexcept : words{} {}
+        constexpr wide_id(std::uint64_t x) noexcept : words{x} {}
+
+        //! The lowest bits of the id
+        template <typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+        explicit constexpr operator T() const noexcept
+        {
+            return static_cast<T>(words[0]);
+        }
+
+        friend constexpr wide_id operator&(wide_id a, wide_id const& b) noexcept
+        {
+            for (std::size_t i = 0; i < Words; ++i)
+                a.words[i] &= b.words[i];
+            return a;
+        }
+
+        friend constexpr wide_id operator|(wide_id a, wide_id const& b) noexcept
+        {
+            for (std::size_t i = 0; i < Words; ++i)
+                a.words[i] |= b.words[i];
+            return a;
+        }
+
+        friend constexpr wide_id operator^(wide_id a, wide_id const& b) noexcept
+        {
+            for (std::size_t i = 0; i < Words; ++i)
+                a.words[i] ^= b.words[i];
+            return a;
+        }
+
+        friend constexpr wide_id operator~(wide_id a) noexcept
+        {
+            for (std::size_t i = 0; i < Words; ++i)
+                a.words[i] = ~a.words[i];
+            return a;
+        }
+
+        friend constexpr wide_id operator-(wide_id a, wide_id const& b) noexcept
+        {
+            std::uint64_t borrow = 0;
+            for (std::size_t i = 0; i < Words; ++i)
+            {
+                auto const x = a.words[i];
+                a.words[i] = x - b.words[i] - borrow;
+                borrow = (x < b.words[i]) or (x - b.words[i] < borrow) ? 1 : 0;
+            }
+            return a;
+        }
+
+        friend constexpr wide_id operator<<(wide_id const& a, int n) noexcept
+        {
+            wide_id result;
+            auto const word_shift = std::size_t(n / 64);
+            auto const bit_shift = n % 64;
+            for (std::size_t i = word_shift; i < Words; ++i)
+            {
+                result.words[i] = a.words[i - word_shift] << bit_shift;
+                if (bit_shift != 0 and i > word_shift)
+                    result.words[i] |= a.words[i - word_shift - 1] >> (64 - bit_shift);
+            }
+            return result;
+        }
+
+        friend constexpr wide_id operator>>(wide_id const& a, int n) noexcept
+        {
+            wide_id result;
+            auto const word_shift = std::size_t(n / 64);
+            auto const bit_shift = n % 64;
+            for (std::size_t i = 0; i + word_shift < Words; ++i)
+            {
+                result.words[i] = a.words[i + word_shift] >> bit_shift;
+                if (bit_shift != 0 and i + word_shift + 1 < Words)
+                    result.words[i] |= a.words[i + word_shift + 1] << (64 - bit_shift);
+            }
+            return result;
+        }
+
+        friend constexpr bool operator==(wide_id const& a, wide_id const& b) noexcept
+        {
+            for (std::size_t i = 0; i < Words; ++i)
+                if (a.words[i] != b.words[i])
+                    return false;
+            return true;
+        }
+
+        friend constexpr bool operator!=(wide_id const& a, wide_id const& b) noexcept
+        {
+            return not (a == b);
+        }
+
+        friend constexpr bool operator<(wide_id const& a, wide_id const& b) noexcept
+        {
+            for (std::size_t i = Words; i-- > 0; )
+                if (a.words[i] != b.words[i])
+                    return a.words[i] < b.words[i];
+            return false;
+        }
+    };
+
+
+    // (id & mask) == value, the test of convertible_to
+    template <typename Id>
+    constexpr auto equal_under_mask(Id id, Id mask, Id value) -> std::enable_if_t<std::is_integral<Id>::value, bool>
+    {
+        return (id & mask) == value;
+    }
+
+#if defined(NI_TYPE_HIERARCHY_AVX2)
+
+    template <std::size_t Words>
+    auto equal_under_mask(wide_id<Words> const& id, wide_id<Words> const& mask, wide_id<Words> const& value)
+    -> std::enable_if_t<Words % 4 == 0, bool>
+    {
+        auto diff = _mm256_setzero_si256();
+        for (std::size_t i = 0; i < Words; i += 4)
+        {
+            auto const x = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(id.words + i));
+            auto const m = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(mask.words + i));
+            auto const v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(value.words + i));
+            diff = _mm256_or_si256(diff, _mm256_xor_si256(_mm256_and_si256(x, m), v));
+        }
+        return _mm256_testz_si256(diff, diff) != 0;
+    }
+
+    template <std::size_t Words>
+    auto equal_under_mask(wide_id<Words> const& id, wide_id<Words> const& mask, wide_id<Words> const& value)
+    -> std::enable_if_t<Words % 4 != 0, bool>
+    {
+        auto diff = _mm_setzero_si128();
+        for (std::size_t i = 0; i < Words; i += 2)
+        {
+            auto const x = _mm_load_si128(reinterpret_cast<__m128i const*>(id.words + i));
+            auto const m = _mm_load_si128(reinterpret_cast<__m128i const*>(mask.words + i));
+            auto const v = _mm_load_si128(reinterpret_cast<__m128i const*>(value.words + i));
+            diff = _mm_or_si128(diff, _mm_xor_si128(_mm_and_si128(x, m), v));
+        }
+        return _mm_testz_si128(diff, diff) != 0;
+    }
+
+#elif defined(NI_TYPE_HIERARCHY_SSE2)
+
+    template <std::size_t Words>
+    bool equal_under_mask(wide_id<Words> const& id, wide_id<Words> const& mask, wide_id<Words> const& value)
+    {
+        auto diff = _mm_setzero_si128();
+        for (std::size_t i = 0; i < Words; i += 2)
+        {
+            auto const x = _mm_load_si128(reinterpret_cast<__m128i const*>(id.words + i));
+            auto const m = _mm_load_si128(reinterpret_cast<__m128i const*>(mask.words + i));
+            auto const v = _mm_load_si128(reinterpret_cast<__m128i const*>(value.words + i));
+            diff = _mm_or_si128(diff, _mm_xor_si128(_mm_and_si128(x, m), v));
+        }
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128())) == 0xffff;
+    }
+
+#else
+
+    template <std::size_t Words>
+    bool equal_under_mask(wide_id<Words> const& id, wide_id<Words> const& mask, wide_id<Words> const& value)
+    {
+        std::uint64_t diff = 0;
+        for (std::size_t i = 0; i < Words; ++i)
+            diff |= (id.words[i] & mask.words[i]) ^ value.words[i];
+        return diff == 0;
+    }
+
+#endif
+
+
+    // folds an id into 64 bits, e.g. for hashing
+    template <typename Id>
+    constexpr auto fold_id(Id id) -> std::enable_if_t<std::is_integral<Id>::value, std::uint64_t>
+    {
+        return std::uint64_t(id);
+    }
+
+    template <std::size_t Words>
+    constexpr std::uint64_t fold_id(wide_id<Words> const& id)
+    {
+        std::uint64_t x = 0;
+        for (std::size_t i = 0; i < Words; ++i)
+            x = (x ^ id.words[i]) * 0x100000001B3ull;
+        return x;
+    }
+
+}
+
+}
@@ -0,0 +1,196 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+#include <ni/functional/adaptive_matcher.h>
+#include <ni/functional/matchable_any.h>
+#include <ni/type_hierarchy.h>
+
+#include <gtest/gtest.h>
+
+#include <any>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace adaptive_matcher_test
+{
+    // a sum type that counts the cases that are tried
+    struct shape
+    {
+        int tag;
+    };
+
+    template <int Tag>
+    struct shape_of : shape
+    {
+        static constexpr int tag_value = Tag;
+        shape_of() : shape{Tag} {}
+    };
+
+    using circle = shape_of<1>;
+    using square = shape_of<2>;
+    using triangle = shape_of<3>;
+    using line = shape_of<4>;
+
+    int probes = 0;
+
+    template <typename Target>
+    Target* dyn_cast(shape* s)
+    {
+        ++probes;
+        return s->tag == Target::tag_value ? static_cast<Target*>(s) : nullptr;
+    }
+
+    template <typename Target1, typename Target2>
+    auto dyn_disjoint(ni::meta::type_list<Target1, Target2>, shape const*)
+    -> std::integral_constant<bool, not std::is_same<Target1, Target2>::value>
+    {
+        return {};
+    }
+
+    int classify(shape& s)
+    {
+        return ni::adaptive_match(s)
+        (   [](circle&)   { return 1; }
+        ,   [](square&)   { return 2; }
+        ,   [](triangle&) { return 3; }
+        ,   [](line&)     { return 4; }
+        ,   []            { return 0; }
+        );
+    }
+
+
+    struct EventBase {};
+    using Event = ni::type_hierarchy::from_base<EventBase, 8, 8>;
+
+    struct MouseEvent : ni::sub_type<MouseEvent, Event> {};
+    struct MouseDown : ni::sub_type<MouseDown, MouseEvent> {};
+    struct KeyEvent : ni::sub_type<KeyEvent, Event> {};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST( ni_adaptive_matcher, hot_cases_are_tried_first )
+{
+    using namespace adaptive_matcher_test;
+
+    circle c; line l;
+    EXPECT_EQ( 1, classify(c) );
+
+    probes = 0;
+    EXPECT_EQ( 4, classify(l) );
+    EXPECT_EQ( 4, probes );
+
+    for (int i = 0; i < 100000; ++i)
+        EXPECT_EQ( 4, classify(l) );
+
+    probes = 0;
+    EXPECT_EQ( 4, classify(l) );
+    EXPECT_EQ( 1, probes );
+    EXPECT_EQ( 1, classify(c) );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST( ni_adaptive_matcher, overlapping_cases_keep_their_order )
+{
+    using namespace adaptive_matcher_test;
+
+    auto m = ni::adaptive_matcher
+    (   [](MouseEvent&) { return 1; }
+    ,   [](KeyEvent&)   { return 2; }
+    ,   [](MouseDown&)  { return 3; }    // shadowed by the first case
+    ,   []              { return 0; }
+    );
+
+    MouseDown d; KeyEvent k;
+    for (int i = 0; i < 100000; ++i)
+    {
+        ASSERT_EQ( 1, m(static_cast<Event&>(d)) );
+        ASSERT_EQ( 2, m(static_cast<Event&>(k)) );
+    }
+
+    struct base { virtual ~base() = default; };
+    struct derived : base {};
+    struct other : base {};
+
+    auto n = ni::adaptive_matcher
+    (   [](base&)    { return 1; }
+    ,   [](derived&) { return 2; }
+    ,   [](other&)   { return 3; }
+    );
+
+    derived x;
+    for (int i = 0; i < 100000; ++i)
+        ASSERT_EQ( 1, *n(static_cast<base&>(x)) );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST( ni_adaptive_matcher, matches_any )
+{
+    auto m = ni::adaptive_matcher
+    (   [](int x)         { return x + 1; }
+    ,   [](double x)      { return int(x) + 2; }
+    ,   [](char const* s) { return int(s[0]); }
+    ,   []                { return -42; }
+    );
+
+    std::any a;
+    EXPECT_EQ( -42, m(a) );
+
+    for (int i = 0; i < 100000; ++i)
+    {
+        a = 7355.;
+        ASSERT_EQ( 7357, m(a) );
+    }
+
+    a = 1336;
+    EXPECT_EQ( 1337, m(a) );
+
+    a = "x";
+    EXPECT_EQ( 'x', m(a) );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST( ni_adaptive_matcher, is_thread_safe )
+{
+    using namespace adaptive_matcher_test;
+
+    auto run = [](int tag)
+    {
+        auto m = ni::adaptive_matcher
+        (   [](MouseEvent const&) { return 1; }
+        ,   [](KeyEvent const&)   { return 2; }
+        ,   [](MouseDown const&)  { return 3; }
+        );
+
+        MouseEvent e; KeyEvent k;
+        for (int i = 0; i < 100000; ++i)
+        {
+            Event const& x = (i % 8 < tag) ? static_cast<Event const&>(k) : e;
+            if (*m(x) != ((i % 8 < tag) ? 2 : 1))
+                return false;
+        }
+        return true;
+    };
+
+    bool ok[4] = {};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+        threads.emplace_back([&ok, &run, t] { ok[t] = run(2 * t); });
+    for (auto& t : threads)
+        t.join();
+
+    for (bool b : ok)
+        EXPECT_TRUE( b );
+}
@@ -0,0 +1,182 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+#include <gtest/gtest.h>
+
+#include <ni/type_hierarchy/factory.h>
+#include <ni/functional/match.h>
+
+#include <cstring>
+#include <memory_resource>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace factory_test
+{
+    struct EventBase {};
+
+    using Event = ni::type_hierarchy::from_base<EventBase>;
+
+    struct MouseEvent : ni::sub_type<MouseEvent, Event>
+    {
+        MouseEvent(ni::type_hierarchy::bytes data)
+        {
+            BOOST_ASSERT( data.size == sizeof(x) + sizeof(y) );
+            std::memcpy(&x, data.data, sizeof(x));
+            std::memcpy(&y, static_cast<char const*>(data.data) + sizeof(x), sizeof(y));
+        }
+        int x, y;
+    };
+
+    struct MouseDown : ni::sub_type<MouseDown, MouseEvent>
+    {
+        MouseDown(ni::type_hierarchy::bytes data) : super_t{data} {}
+    };
+
+    struct KeyEvent : ni::sub_type<KeyEvent, Event>
+    {
+        KeyEvent(ni::type_hierarchy::bytes data) : key{*static_cast<char const*>(data.data)} {}
+        char key;
+    };
+
+    struct ThrowingEvent : ni::sub_type<ThrowingEvent, Event>
+    {
+        ThrowingEvent(ni::type_hierarchy::bytes) { throw std::runtime_error{"invalid data"}; }
+    };
+
+    struct UndefinedEvent : ni::sub_type<UndefinedEvent, Event> {};
+
+    using factory = ni::type_hierarchy::factory<Event>;
+
+    static auto const mouse_down_defined = factory::define<MouseDown>();
+    static auto const mouse_defined = factory::define<MouseEvent>();
+    static auto const key_defined = factory::define<KeyEvent>();
+    static auto const throwing_defined = factory::define<ThrowingEvent>();
+
+    struct counting_resource : std::pmr::memory_resource
+    {
+        int allocated = 0;
+
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override
+        {
+            ++allocated;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+        {
+            --allocated;
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+
+        bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override { return this == &other; }
+    };
+}
+
+using namespace factory_test;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST(FactoryTest, create_objects_from_ids)
+{
+    struct record { factory::id_t id; std::vector<char> data; };
+
+    int const xy[] = { 13, 37 };
+    std::vector<char> const mouse_data(reinterpret_cast<char const*>(xy), reinterpret_cast<char const*>(xy + 2));
+
+    std::vector<record> const stream =
+    {   { ni::type_hierarchy_detail::id_of<MouseDown>::init(), mouse_data }
+    ,   { ni::type_hierarchy_detail::id_of<KeyEvent>::init(), {'k'} }
+    ,   { ni::type_hierarchy_detail::id_of<MouseEvent>::init(), mouse_data }
+    };
+
+    counting_resource resource;
+    std::vector<Event*> events;
+    for (auto const& r : stream)
+        events.push_back(ni::type_hierarchy::create<Event>(r.id, resource, {r.data.data(), r.data.size()}));
+
+    EXPECT_EQ( 3, resource.allocated );
+
+    std::vector<int> values;
+    for (auto* e : events)
+        ni::match(*e)
+        (   [&](MouseDown const& m)  { values.push_back(-m.x); }
+        ,   [&](MouseEvent const& m) { values.push_back(m.y); }
+        ,   [&](KeyEvent const& k)   { values.push_back(k.key); }
+        );
+    EXPECT_EQ( (std::vector<int>{-13, 'k', 37}), values );
+
+    for (auto* e : events)
+        factory::destroy(e, resource);
+    EXPECT_EQ( 0, resource.allocated );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST(FactoryTest, unknown_ids_and_throwing_constructors)
+{
+    counting_resource resource;
+    char const data[] = { 'x' };
+
+    EXPECT_EQ( nullptr, factory::find(ni::type_hierarchy_detail::id_of<UndefinedEvent>::init()) );
+    EXPECT_EQ( nullptr, factory::find(0) );
+    EXPECT_EQ( nullptr, factory::create(0x4242, resource, {data, 1}) );
+    EXPECT_THROW( factory::create(ni::type_hierarchy_detail::id_of<ThrowingEvent>::init(), resource, {data, 1}), std::runtime_error );
+    EXPECT_EQ( 0, resource.allocated );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST(FactoryTest, construct_into_caller_storage)
+{
+    auto const* c = factory::find(ni::type_hierarchy_detail::id_of<KeyEvent>::init());
+    ASSERT_NE( nullptr, c );
+    EXPECT_EQ( sizeof(KeyEvent), c->size );
+    EXPECT_EQ( alignof(KeyEvent), c->alignment );
+
+    alignas(KeyEvent) unsigned char storage[sizeof(KeyEvent)];
+    char const key = 'q';
+    Event* e = c->construct(storage, {&key, 1});
+
+    EXPECT_EQ( static_cast<void*>(storage), static_cast<void*>(static_cast<KeyEvent*>(e)) );
+    EXPECT_EQ( 'q', static_cast<KeyEvent*>(e)->key );
+    c->destruct(e);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST(FactoryTest, types_can_be_defined_again_after_removal)
+{
+    struct PluginEvent : ni::sub_type<PluginEvent, Event>
+    {
+        PluginEvent(ni::type_hierarchy::bytes data) : value{*static_cast<char const*>(data.data)} {}
+        char value;
+    };
+
+    auto const id = ni::type_hierarchy_detail::id_of<PluginEvent>::init();
+    counting_resource resource;
+    char const data[] = { 'p' };
+
+    auto plugin = factory::define<PluginEvent>();
+    EXPECT_EQ( plugin.get(), factory::find(id) );
+
+    plugin.reset();
+    EXPECT_EQ( nullptr, factory::find(id) );
+    EXPECT_EQ( nullptr, factory::create(id, resource, {data, 1}) );
+    EXPECT_NE( nullptr, factory::find(ni::type_hierarchy_detail::id_of<MouseEvent>::init()) );
+
+    plugin = factory::define<PluginEvent>();
+    auto* e = factory::create(id, resource, {data, 1});
+    ASSERT_NE( nullptr, e );
+    EXPECT_EQ( 'p', static_cast<PluginEvent*>(e)->value );
+    factory::destroy(e, resource);
+    EXPECT_EQ( 0, resource.allocated );
+}
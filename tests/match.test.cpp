@@ -11,6 +11,7 @@
 #include <ni/functional/match.h>
 
 #include <gtest/gtest.h>
+#include <boost/optional/optional_io.hpp>
 
 #include <memory>
 #include <vector>
@@ -183,6 +184,20 @@ TEST( ni_match, otherwise_value_can_be_at_any_position )
 
 //----------------------------------------------------------------------------------------------------------------------
 
+TEST( ni_match, matcher_with_only_a_default )
+{
+    struct base { virtual ~base(){} };
+    struct derived : base { };
+
+    derived d;
+    base& b = d;
+
+    EXPECT_EQ( 5, ni::match(b)(ni::otherwise(5)) );
+    EXPECT_EQ( 5, ni::matcher([]{ return 5; })(b) );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
 namespace ni_match_test_detail
 {
     struct AnyNumber
@@ -220,3 +235,195 @@ TEST( ni_match, match_on_rvalues )
     EXPECT_TRUE(ni::match(get_int())([](int const& i){ EXPECT_EQ(1337, i); } ));
     EXPECT_TRUE(ni::match(get_float())([](float const& f){ EXPECT_EQ(3.14f, f); } ));
 }
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST( ni_match, match_pairs_of_polymorphic_types )
+{
+    struct base { virtual ~base(){} };
+    struct derived1 : base {};
+    struct derived2 : base {};
+    struct derived3 : derived1 {};
+
+    derived1 d1;
+    derived2 d2;
+    derived3 d3;
+
+    auto f = ni::matcher
+    (   [](derived1&, base&)     { return 1; }
+    ,   [](base&, derived2&)     { return 2; }
+    ,   [](derived3&, derived2&) { return 3; }
+    ,   []                       { return 0; }
+    );
+
+    base& b1 = d1;
+    base& b2 = d2;
+    base& b3 = d3;
+
+    EXPECT_EQ( 1, f(b1, b1) );
+    EXPECT_EQ( 1, f(b1, b2) );      // both cases have the same rank, the first one wins
+    EXPECT_EQ( 2, f(b2, b2) );
+    EXPECT_EQ( 3, f(b3, b2) );      // most specific pair
+    EXPECT_EQ( 1, f(b3, b3) );
+    EXPECT_EQ( 0, f(b2, b1) );
+
+    EXPECT_EQ( boost::optional<int>{2}, ni::match(b2, b2)( [](base&, derived2&) { return 2; } ) );
+    EXPECT_EQ( boost::none, ni::match(b1, b1)( [](base&, derived2&) { return 2; } ) );
+    EXPECT_TRUE( ni::match(b1, b3)( [](derived1 const&, derived3 const&) {} ) );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST( ni_match, match_pairs_on_unrelated_interfaces )
+{
+    struct base { virtual ~base(){} };
+    struct interface1 { virtual ~interface1(){} };
+    struct interface2 { virtual ~interface2(){} };
+    struct both : base, interface1, interface2 {};
+    struct only1 : base, interface1 {};
+    struct x : base {};
+    struct y : base {};
+
+    both b;
+    only1 o;
+    x xx;
+    y yy;
+
+    base& bb = b;
+    base& bo = o;
+    base& bx = xx;
+    base& by = yy;
+
+    auto f = ni::matcher
+    (   [](interface1&, x&) { return 1; }
+    ,   [](interface2&, y&) { return 2; }
+    ,   []                  { return 0; }
+    );
+
+    EXPECT_EQ( 1, f(bb, bx) );
+    EXPECT_EQ( 2, f(bb, by) );
+    EXPECT_EQ( 1, f(bo, bx) );
+    EXPECT_EQ( 0, f(bo, by) );
+    EXPECT_EQ( 0, f(bx, bx) );
+
+    EXPECT_EQ( boost::optional<int>{2}, ni::match(bb, by)
+    (   [](interface1&, x&) { return 1; }
+    ,   [](interface2&, y&) { return 2; }
+    ));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace ni_match_test_detail
+{
+    struct counted_base { virtual ~counted_base(){} };
+    struct counted_a : counted_base {};
+    struct counted_b : counted_base {};
+    struct unrelated final {};
+
+    int number_of_casts = 0;
+
+    template <typename TargetType>
+    TargetType* dyn_cast(counted_base* p) { ++number_of_casts; return dynamic_cast<TargetType*>(p); }
+
+    template <typename TargetType>
+    TargetType const* dyn_cast(counted_base const* p) { ++number_of_casts; return dynamic_cast<TargetType const*>(p); }
+
+    // pretend counted_a is final, so it's never a counted_b
+    template <typename TargetType>
+    auto dyn_cast_never(counted_a const*) -> std::integral_constant<bool, std::is_same<TargetType, counted_b>::value>
+    {
+        return {};
+    }
+}
+
+TEST( ni_match, cases_decided_by_the_static_type_need_no_cast )
+{
+    using namespace ni_match_test_detail;
+
+    struct base { virtual ~base(){} };
+    struct derived : base {};
+
+    static_assert( std::is_same<ni::detail::static_case_t<base, derived>, ni::detail::always_matches>::value, "" );
+    static_assert( std::is_same<ni::detail::static_case_t<unrelated, base>, ni::detail::never_matches>::value, "" );
+    static_assert( std::is_same<ni::detail::static_case_t<derived, base>, ni::detail::may_match>::value, "" );
+    static_assert( std::is_same<ni::detail::static_case_t<counted_b, counted_a>, ni::detail::never_matches>::value, "" );
+
+    counted_a a;
+    counted_base& b = a;
+
+    number_of_casts = 0;
+    EXPECT_EQ( 2, *ni::match(a)
+    (   [](counted_b&)    { return 1; }     // dropped
+    ,   [](counted_base&) { return 2; }     // taken without a cast
+    ,   [](counted_a&)    { return 3; }     // never reached
+    ));
+    EXPECT_EQ( 0, number_of_casts );
+
+    EXPECT_EQ( 3, *ni::match(b)
+    (   [](counted_b&)    { return 1; }
+    ,   [](counted_a&)    { return 3; }
+    ,   [](counted_base&) { return 2; }
+    ));
+    EXPECT_EQ( 2, number_of_casts );
+
+    derived d;
+    EXPECT_EQ( 0, ni::match(d)( [](unrelated&) { return 1; }, [] { return 0; } ) );
+    EXPECT_EQ( 1, ni::match(static_cast<base const&>(d))( [](derived const&) { return 1; }, [] { return 0; } ) );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace ni_match_test_detail
+{
+    // a tagged union, the tag is the index of the type in dyn_closed()
+    struct shape
+    {
+        explicit shape(std::size_t t) : tag(t) {}
+        std::size_t tag;
+    };
+
+    struct circle : shape { circle() : shape(0) {} };
+    struct square : shape { square() : shape(1) {} };
+    struct rounded_square : square { rounded_square() { tag = 2; } };
+
+    int number_of_key_lookups = 0;
+
+    std::size_t dyn_key(shape const* s) { ++number_of_key_lookups; return s->tag; }
+
+    ni::meta::type_list<circle, square, rounded_square> dyn_closed(shape const*);
+
+    template <typename TargetType>
+    TargetType* dyn_cast(shape*) { ADD_FAILURE() << "the case is selected by the key"; return nullptr; }
+}
+
+TEST( ni_match, match_selects_the_case_by_the_key_of_the_type )
+{
+    using namespace ni_match_test_detail;
+
+    circle          c;
+    square          s;
+    rounded_square  r;
+
+    auto f = ni::matcher
+    (   [](rounded_square&) { return 3; }
+    ,   [](circle&)         { return 1; }
+    ,   [](square&)         { return 2; }
+    );
+
+    auto partial = ni::matcher
+    (   [](square&) { return 2; }
+    ,   []          { return 0; }
+    );
+
+    number_of_key_lookups = 0;
+
+    EXPECT_EQ( 1, f(static_cast<shape&>(c)) );
+    EXPECT_EQ( 2, f(static_cast<shape&>(s)) );
+    EXPECT_EQ( 3, f(static_cast<shape&>(r)) );
+    EXPECT_EQ( 0, partial(static_cast<shape&>(c)) );
+    EXPECT_EQ( 2, partial(static_cast<shape&>(r)) );
+    EXPECT_EQ( 5, number_of_key_lookups );
+
+    static_assert( std::is_same<int, decltype(f(std::declval<shape&>()))>::value, "the keys are exhaustive" );
+}
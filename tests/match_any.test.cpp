@@ -13,6 +13,9 @@
 
 #include <gtest/gtest.h>
 
+#include <iterator>
+#include <string>
+
 
 TEST( ni_match, match_any )
 {
@@ -36,3 +39,29 @@ TEST( ni_match, match_any )
     EXPECT_EQ( 7357, m(const_any) );
 }
 
+
+TEST( ni_match, match_any_selects_the_first_case_of_the_type )
+{
+    auto m = ni::matcher
+    (   [](std::string const&) { return 1; }
+    ,   [](int)                { return 2; }
+    ,   [](int const&)         { return 3; }
+    ,   [](double)             { return 4; }
+    ,   []                     { return 0; }
+    );
+
+    std::any values[] = { std::any{}, 1, std::string("x"), 2., 'c', 3, 4. };
+    int const expected[] = { 0, 2, 1, 4, 0, 2, 4 };
+
+    // twice, the second time the types are cached
+    for (int pass = 0; pass < 2; ++pass)
+        for (std::size_t i = 0; i < std::size(values); ++i)
+            EXPECT_EQ( expected[i], m(values[i]) );
+
+    using table_t = ni::detail::any_case_table<std::string, int, int, double>;
+    EXPECT_EQ( 1u, table_t::lookup(typeid(int)) );
+    EXPECT_EQ( 1u, table_t::lookup(typeid(int)) );
+    EXPECT_EQ( 3u, table_t::lookup(typeid(double)) );
+    EXPECT_EQ( 4u, table_t::lookup(typeid(char)) );
+    EXPECT_EQ( 0u, ni::detail::any_case_table<>::lookup(typeid(int)) );
+}
@@ -0,0 +1,165 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+#include <ni/functional/match_each.h>
+#include <ni/functional/matchable_variant.h>
+#include <ni/type_hierarchy.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST( ni_match_each, polymorphic_types_by_pointer )
+{
+    struct base { virtual ~base(){} };
+    struct derived1 : base { int value = 1; };
+    struct derived2 : base { int value = 10; };
+    struct derived3 : base {};
+
+    derived1 d1;
+    derived2 d2;
+    derived3 d3;
+
+    const std::vector<base*> objects = { &d1, &d2, nullptr, &d3, &d1, &d2, &d2 };
+
+    int sum = 0, others = 0;
+    ni::match_each(objects
+    ,   [&](derived1 const& x) { sum += x.value; }
+    ,   [&](derived2 const& x) { sum += x.value; }
+    ,   [&] { ++others; }
+    );
+
+    EXPECT_EQ( 2 * 1 + 3 * 10, sum );
+    EXPECT_EQ( 1, others );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST( ni_match_each, smart_pointers_and_objects )
+{
+    struct base { virtual ~base(){} };
+    struct derived1 : base { int value = 1; };
+    struct derived2 : base { int value = 10; };
+
+    const auto objects = std::vector<std::shared_ptr<base>>
+    {   std::make_shared<derived1>()
+    ,   std::make_shared<derived2>()
+    ,   std::make_shared<derived1>()
+    };
+
+    int sum = 0;
+    ni::match_each(objects, [&](derived1& x) { sum += x.value; });
+    EXPECT_EQ( 2, sum );
+
+    std::vector<derived2> values(3);
+    ni::match_each(values, [&](base&) { ++sum; });
+    EXPECT_EQ( 5, sum );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace
+{
+    struct EventBase { int order = 0; };
+
+    using Event = ni::type_hierarchy::from_base<EventBase>;
+
+    struct MouseEvent : ni::sub_type<MouseEvent, Event> {};
+    struct MouseDown : ni::sub_type<MouseDown, MouseEvent> {};
+    struct MouseUp : ni::sub_type<MouseUp, MouseEvent> {};
+    struct KeyEvent : ni::sub_type<KeyEvent, Event> {};
+    struct TouchEvent : ni::sub_type<TouchEvent, Event> {};
+    struct WheelEvent : ni::sub_type<WheelEvent, Event> {};
+
+    template <typename T>
+    std::unique_ptr<Event> make_event(int order)
+    {
+        auto e = std::make_unique<T>();
+        e->order = order;
+        return e;
+    }
+}
+
+TEST( ni_match_each, keep_order_within_cases )
+{
+    std::vector<std::unique_ptr<Event>> events;
+    for (int n = 0; n < 100; ++n)
+        switch (n % 5)
+        {
+            case 0: events.push_back(make_event<MouseDown>(n)); break;
+            case 1: events.push_back(make_event<KeyEvent>(n)); break;
+            case 2: events.push_back(make_event<MouseUp>(n)); break;
+            case 3: events.push_back(make_event<TouchEvent>(n)); break;
+            case 4: events.push_back(make_event<WheelEvent>(n)); break;
+        }
+
+    std::vector<int> mouse, keys, other;
+    ni::match_each(ni::keep_order, events
+    ,   [&](MouseEvent const& e) { mouse.push_back(e.order); }
+    ,   [&](KeyEvent const& e) { keys.push_back(e.order); }
+    ,   [&](TouchEvent const& e) { other.push_back(e.order); }
+    ,   [&](WheelEvent const& e) { other.push_back(e.order); }
+    );
+
+    ASSERT_EQ( 40u, mouse.size() );
+    ASSERT_EQ( 20u, keys.size() );
+    ASSERT_EQ( 40u, other.size() );
+    EXPECT_TRUE( std::is_sorted(mouse.begin(), mouse.end()) );
+    EXPECT_TRUE( std::is_sorted(keys.begin(), keys.end()) );
+    EXPECT_TRUE( std::is_sorted(other.begin(), other.begin() + 20) );
+    EXPECT_EQ( 3, other.front() );
+    EXPECT_EQ( 4, other[20] );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST( ni_match_each, unordered_visits_each_object_once )
+{
+    std::vector<std::unique_ptr<Event>> events;
+    for (int n = 0; n < 100; ++n)
+        events.push_back(n % 3 ? make_event<MouseUp>(n) : make_event<KeyEvent>(n));
+
+    std::vector<int> visited(100, 0);
+    int keys = 0;
+    ni::match_each(events
+    ,   [&](MouseEvent& e) { ++visited[e.order]; }
+    ,   [&](KeyEvent& e) { ++visited[e.order]; ++keys; }
+    );
+
+    EXPECT_EQ( std::vector<int>(100, 1), visited );
+    EXPECT_EQ( 34, keys );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST( ni_match_each, variants_with_cases_for_bases_of_alternatives )
+{
+    struct base { int value; };
+    struct derived1 : base {};
+    struct derived2 : base {};
+
+    using var_t = std::variant<derived1, int, derived2>;
+
+    std::vector<var_t> values = { derived1{{1}}, 10, derived2{{2}}, 20, derived1{{3}} };
+
+    int ints = 0;
+    int bases = 0;
+    ni::match_each(values
+    ,   [&](int x)         { ints += x; }
+    ,   [&](base const& b) { bases += b.value; }
+    );
+
+    EXPECT_EQ( 30, ints );
+    EXPECT_EQ( 6, bases );
+}
@@ -0,0 +1,157 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+// built into its own test binary, the instrumentation has to be enabled for the whole program
+#define NI_MATCH_INSTRUMENTATION 1
+#define NI_MATCH_INSTRUMENTATION_CYCLES 1
+
+#include <gtest/gtest.h>
+
+#include <ni/functional/match.h>
+#include <ni/type_hierarchy.h>
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace
+{
+    struct EventBase {};
+    using Event = ni::type_hierarchy::from_base<EventBase>;
+
+    struct MouseEvent : ni::sub_type<MouseEvent, Event> {};
+    struct KeyEvent : ni::sub_type<KeyEvent, Event> {};
+    struct TextEvent : ni::sub_type<TextEvent, Event> {};
+    struct TimerEvent : ni::sub_type<TimerEvent, Event> {};
+
+    int classify(Event const& e)
+    {
+        return ni::match(e)
+        (   [](MouseEvent const&) { return 1; }
+        ,   [](KeyEvent const&)   { return 2; }
+        ,   []                    { return 0; }
+        );
+    }
+
+    bool handle(Event const& e)
+    {
+        return ni::match(e)
+        (   [](MouseEvent const&) {}
+        ,   [](KeyEvent const&)   {}
+        ,   [](TextEvent const&)  {}
+        ,   [](TimerEvent const&) {}
+        );
+    }
+
+    // the sites are told apart by the signatures of their cases
+    ni::match_stats::site_stats site_of(std::string const& first_case, std::size_t num_cases)
+    {
+        for (auto const& site : ni::match_stats::snapshot())
+            if (site.cases.size() == num_cases and site.cases[0].signature.find(first_case) != std::string::npos)
+                return site;
+        return {};
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST(MatchStatsTest, counts_cases_and_misses_per_site)
+{
+    ni::match_stats::reset();
+
+    MouseEvent m; KeyEvent k; TextEvent t;
+    for (int i = 0; i < 3; ++i)
+        classify(m);
+    classify(k);
+    classify(t);
+    classify(t);
+
+    auto const site = site_of("MouseEvent", 3);
+    ASSERT_EQ( 3u, site.cases.size() );
+    EXPECT_EQ( 6u, site.calls );
+    EXPECT_EQ( 2u, site.misses );
+    EXPECT_EQ( 3u, site.cases[0].hits );
+    EXPECT_EQ( 1u, site.cases[1].hits );
+    EXPECT_EQ( 2u, site.cases[2].hits );
+    EXPECT_TRUE( site.cases[2].is_default );
+    EXPECT_FALSE( site.cases[0].is_default );
+    EXPECT_NE( std::string::npos, site.cases[1].signature.find("KeyEvent") );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST(MatchStatsTest, table_dispatch_is_counted)
+{
+    ni::match_stats::reset();
+
+    MouseEvent m; TimerEvent t;
+    EXPECT_TRUE( handle(t) );
+    EXPECT_TRUE( handle(t) );
+    EXPECT_TRUE( handle(m) );
+
+    auto const site = site_of("MouseEvent", 4);
+    EXPECT_EQ( 3u, site.calls );
+    EXPECT_EQ( 0u, site.misses );
+    EXPECT_EQ( 1u, site.cases[0].hits );
+    EXPECT_EQ( 2u, site.cases[3].hits );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST(MatchStatsTest, counters_of_threads_are_merged)
+{
+    ni::match_stats::reset();
+
+    std::vector<std::thread> threads;
+    for (int n = 0; n < 4; ++n)
+        threads.emplace_back([]
+        {
+            KeyEvent k;
+            for (int i = 0; i < 1000; ++i)
+                classify(k);
+        });
+    for (auto& t : threads)
+        t.join();
+
+    KeyEvent k;
+    classify(k);
+
+    auto const site = site_of("MouseEvent", 3);
+    EXPECT_EQ( 4001u, site.calls );
+    EXPECT_EQ( 4001u, site.cases[1].hits );
+    EXPECT_EQ( 0u, site.misses );
+
+    ni::match_stats::reset();
+    EXPECT_EQ( 0u, site_of("MouseEvent", 3).calls );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST(MatchStatsTest, dumps_text_and_json)
+{
+    ni::match_stats::reset();
+
+    MouseEvent m;
+    classify(m);
+
+    std::ostringstream text;
+    ni::match_stats::dump_text(text);
+    EXPECT_NE( std::string::npos, text.str().find("1 calls, 0 misses") );
+
+    std::ostringstream json;
+    ni::match_stats::dump_json(json);
+    EXPECT_EQ( '[', json.str().front() );
+    EXPECT_NE( std::string::npos, json.str().find("\"calls\": 1, \"misses\": 0") );
+    EXPECT_NE( std::string::npos, json.str().find("\"default\": true") );
+}
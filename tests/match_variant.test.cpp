@@ -0,0 +1,127 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+#include <ni/functional/match.h>
+#include <ni/functional/matchable_variant.h>
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+TEST( ni_match, match_variant )
+{
+    using var_t = std::variant<int, double, std::string>;
+
+    auto m = ni::matcher
+    (   [](int x)    { return x + 1; }
+    ,   [](double x) { return int(x) + 2; }
+    ,   []           { return -42; }
+    );
+
+    var_t var = 1336;
+    EXPECT_EQ( 1337, m(var) );
+
+    var = 7355.;
+    EXPECT_EQ( 7357, m(var) );
+
+    var = std::string("not matched");
+    EXPECT_EQ( -42, m(var) );
+
+    auto const& const_var = var;
+    EXPECT_EQ( -42, m(const_var) );
+
+    auto optional = ni::matcher( [](std::string const& s) { return s.size(); } );
+    EXPECT_EQ( 11u, *optional(const_var) );
+    var = 1;
+    EXPECT_FALSE( optional(var) );
+}
+
+TEST( ni_match, exhaustive_match_variant )
+{
+    struct base { int value; };
+    struct derived1 : base {};
+    struct derived2 : base {};
+
+    using var_t = std::variant<derived1, int, derived2>;
+
+    auto m = ni::matcher
+    (   [](int x)         { return x; }
+    ,   [](base const& b) { return b.value; }
+    );
+
+    static_assert( std::is_same<int, decltype(m(std::declval<var_t&>()))>::value, "all alternatives are matched" );
+
+    var_t var = derived2{{3}};
+    EXPECT_EQ( 3, m(var) );
+
+    var = 2;
+    EXPECT_EQ( 2, m(var) );
+
+    var = derived1{{1}};
+    EXPECT_EQ( 1, m(var) );
+
+    var = 4;
+    EXPECT_TRUE( ni::match(var)( [](int& x) { x = 5; } ) );
+    EXPECT_EQ( 5, std::get<int>(var) );
+}
+
+TEST( ni_match, match_valueless_variant )
+{
+    struct throws_on_copy
+    {
+        throws_on_copy() = default;
+        throws_on_copy(throws_on_copy const&) { throw std::runtime_error("copy"); }
+    };
+
+    std::variant<int, throws_on_copy> var;
+    throws_on_copy const t;
+    try { var.emplace<1>(t); } catch (std::runtime_error const&) {}
+    ASSERT_TRUE( var.valueless_by_exception() );
+
+    EXPECT_EQ( 0, ni::match(var)( [](int) { return 1; }, [](throws_on_copy&) { return 2; }, ni::otherwise(0) ) );
+    EXPECT_FALSE( ni::match(var)( [](int) { return 1; } ) );
+
+    auto exhaustive = ni::matcher( [](int) { return 1; }, [](throws_on_copy&) { return 2; } );
+    static_assert( std::is_same<int, decltype(exhaustive(var))>::value, "" );
+    EXPECT_THROW( exhaustive(var), std::bad_variant_access );
+}
+
+namespace
+{
+    template <int N>
+    using alternative = std::integral_constant<int, N>;
+
+    template <int... Ns>
+    auto make_values(std::integer_sequence<int, Ns...>)
+    {
+        using var_t = std::variant<alternative<Ns>...>;
+        return std::vector<var_t>{ var_t{alternative<Ns>{}}... };
+    }
+}
+
+TEST( ni_match, match_variant_with_many_alternatives )
+{
+    // more alternatives than keys in one block of the switch
+    auto const values = make_values(std::make_integer_sequence<int, 40>{});
+
+    auto m = ni::matcher
+    (   [](alternative<37>) { return 37; }
+    ,   [](alternative<3>)  { return 3; }
+    ,   [](alternative<16>) { return 16; }
+    ,   ni::otherwise(-1)
+    );
+
+    for (int i = 0; i < 40; ++i)
+        EXPECT_EQ( (i == 3 or i == 16 or i == 37) ? i : -1, m(values[std::size_t(i)]) );
+}
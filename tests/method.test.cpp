@@ -0,0 +1,125 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+#include <gtest/gtest.h>
+
+#include <ni/type_hierarchy/method.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace method_test
+{
+    struct ShapeBase { int sides = 0; };
+
+    using Shape = ni::type_hierarchy::from_base<ShapeBase>;
+
+    struct Polygon : ni::sub_type<Polygon, Shape> {};
+    struct Triangle : ni::sub_type<Triangle, Polygon> { Triangle() { sides = 3; } };
+    struct Rectangle : ni::sub_type<Rectangle, Polygon> { Rectangle() { sides = 4; } };
+    struct Square : ni::sub_type<Square, Rectangle> {};
+    struct Circle : ni::sub_type<Circle, Shape> {};
+
+    extern ni::type_hierarchy::method<Shape, std::string(Shape const&)> name;
+
+    // defined before the method is, which works since methods are constant initialized
+    static auto const name_polygon = name.define<Polygon>([](Polygon const& p) { return std::to_string(p.sides) + "-gon"; });
+
+    ni::type_hierarchy::method<Shape, std::string(Shape const&)> name;
+
+    static auto const name_square = name.define<Square>([](Square const&) { return std::string{"square"}; });
+}
+
+using namespace method_test;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST(MethodTest, implementations_from_static_initialization)
+{
+    EXPECT_EQ( "3-gon", name(Triangle{}) );
+    EXPECT_EQ( "4-gon", name(Rectangle{}) );
+    EXPECT_EQ( "square", name(Square{}) );
+    EXPECT_THROW( name(Circle{}), ni::type_hierarchy::method_not_implemented );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST(MethodTest, most_derived_implementation_with_fallback)
+{
+    ni::type_hierarchy::method<Shape, int(Shape const&, int)> m;
+
+    auto root = m.define<Shape>([](Shape const&, int x) { return x; });
+    auto rect = m.define<Rectangle>([](Rectangle const& r, int x) { return r.sides * x; });
+
+    EXPECT_EQ( 2, m(Circle{}, 2) );
+    EXPECT_EQ( 2, m(Triangle{}, 2) );
+    EXPECT_EQ( 8, m(Rectangle{}, 2) );
+    EXPECT_EQ( 8, m(Square{}, 2) );
+
+    auto poly = m.define<Polygon>([](Polygon const&, int x) { return -x; });
+    auto square = m.define<Square>([](Square const&, int x) { return 100 * x; });
+
+    EXPECT_EQ( 2, m(Circle{}, 2) );
+    EXPECT_EQ( -2, m(Triangle{}, 2) );
+    EXPECT_EQ( 8, m(Rectangle{}, 2) );
+    EXPECT_EQ( 200, m(Square{}, 2) );
+
+    EXPECT_TRUE( m.implemented_for<Square>() );
+    EXPECT_TRUE( m.implemented_for<Shape>() );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST(MethodTest, destroying_the_handle_removes_the_implementation)
+{
+    ni::type_hierarchy::method<Shape, void(Shape&, int&)> m;
+
+    auto rect = m.define<Rectangle>([](Rectangle& r, int& calls) { r.sides = 0; ++calls; });
+
+    int calls = 0;
+    Square s;
+    m(s, calls);
+    EXPECT_EQ( 0, s.sides );
+    EXPECT_EQ( 1, calls );
+
+    rect.reset();
+    EXPECT_FALSE( m.implemented_for<Square>() );
+    EXPECT_THROW( m(s, calls), ni::type_hierarchy::method_not_implemented );
+
+    rect = m.define<Rectangle>([](Rectangle&, int& calls) { calls += 10; });
+    m(s, calls);
+    EXPECT_EQ( 11, calls );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST(MethodTest, concurrent_calls)
+{
+    ni::type_hierarchy::method<Shape, int(Shape const&)> m;
+    auto poly = m.define<Polygon>([](Polygon const& p) { return p.sides; });
+
+    std::vector<std::thread> threads;
+    std::vector<int> sums(4, 0);
+    for (auto& sum : sums)
+        threads.emplace_back([&m, &sum]
+        {
+            Triangle t;
+            Square s;
+            for (int n = 0; n < 1000; ++n)
+                sum += m(t) + m(s);
+        });
+    for (auto& t : threads)
+        t.join();
+
+    EXPECT_EQ( std::vector<int>(4, 7000), sums );
+}
@@ -0,0 +1,131 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+#include <gtest/gtest.h>
+
+#include <ni/type_hierarchy/of_type.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace
+{
+    template <int... BitsPerLevel>
+    struct Hierarchy
+    {
+        struct Base { int value = 0; };
+
+        using Root = ni::type_hierarchy::from_base<Base, BitsPerLevel...>;
+
+        struct A : ni::sub_type<A, Root> {};
+        struct A1 : ni::sub_type<A1, A> {};
+        struct A2 : ni::sub_type<A2, A> {};
+        struct B : ni::sub_type<B, Root> {};
+        struct B1 : ni::sub_type<B1, B> {};
+    };
+
+    template <typename H>
+    struct ConvertibleToMaskTest : public ::testing::Test
+    {
+        using id_t = typename ni::type_hierarchy_detail::get_config_t<typename H::Root>::id_t;
+
+        std::vector<id_t> ids;
+
+        ConvertibleToMaskTest()
+        {
+            typename H::A a; typename H::A1 a1; typename H::A2 a2; typename H::B b; typename H::B1 b1;
+            id_t const all[] = { a.type_hierarchy_id__(), a1.type_hierarchy_id__(), a2.type_hierarchy_id__()
+                               , b.type_hierarchy_id__(), b1.type_hierarchy_id__() };
+            for (int n = 0; n < 203; ++n)
+                ids.push_back(all[(n * 7 + n / 5) % 5]);
+        }
+
+        template <typename T>
+        void expect_same_as_convertible_to()
+        {
+            std::vector<std::uint64_t> bits((ids.size() + 63) / 64, ~std::uint64_t(0));
+            ni::type_hierarchy::convertible_to_mask<T>(ids.data(), ids.size(), bits.data());
+
+            ni::type_hierarchy_detail::convertible_to_test<T> const test;
+            for (std::size_t i = 0; i < ids.size(); ++i)
+                EXPECT_EQ( (ids[i] & test.mask) == test.value, bool((bits[i / 64] >> (i % 64)) & 1) ) << i;
+
+            EXPECT_EQ( 0u, bits.back() >> (ids.size() % 64) );
+        }
+    };
+
+    using Hierarchies = ::testing::Types<Hierarchy<4, 4>, Hierarchy<8, 8>, Hierarchy<8, 8, 8, 8>, Hierarchy<16, 16, 16, 16>>;
+}
+
+TYPED_TEST_SUITE(ConvertibleToMaskTest, Hierarchies);
+
+TYPED_TEST(ConvertibleToMaskTest, same_as_convertible_to)
+{
+    this->template expect_same_as_convertible_to<typename TypeParam::Root>();
+    this->template expect_same_as_convertible_to<typename TypeParam::A>();
+    this->template expect_same_as_convertible_to<typename TypeParam::A1>();
+    this->template expect_same_as_convertible_to<typename TypeParam::A2>();
+    this->template expect_same_as_convertible_to<typename TypeParam::B>();
+    this->template expect_same_as_convertible_to<typename TypeParam::B1>();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct OfTypeTest : public ::testing::Test
+{
+    using H = Hierarchy<8, 8, 8, 8>;
+
+    template <typename T>
+    static std::unique_ptr<H::Root> make(int value)
+    {
+        auto p = std::make_unique<T>();
+        p->value = value;
+        return p;
+    }
+};
+
+TEST_F(OfTypeTest, yields_typed_references_in_order)
+{
+    std::vector<std::unique_ptr<H::Root>> objects;
+    for (int n = 0; n < 300; ++n)
+        objects.push_back(n % 3 == 0 ? make<H::A1>(n) : n % 3 == 1 ? make<H::B>(n) : make<H::A2>(n));
+    objects.insert(objects.begin() + 100, nullptr);
+
+    std::vector<int> values;
+    for (H::A& a : ni::views::of_type<H::A>(objects))
+        values.push_back(a.value);
+
+    ASSERT_EQ( 200u, values.size() );
+    EXPECT_TRUE( std::is_sorted(values.begin(), values.end()) );
+
+    int count = 0;
+    for (H::B const& b : objects | ni::views::of_type<H::B const>)
+        count += b.value % 3 == 1;
+    EXPECT_EQ( 100, count );
+}
+
+TEST_F(OfTypeTest, objects_and_empty_ranges)
+{
+    std::vector<H::A1> objects(70);
+    objects[69].value = 42;
+
+    auto view = ni::views::of_type<H::A>(objects);
+    EXPECT_EQ( 70, std::distance(view.begin(), view.end()) );
+    EXPECT_EQ( 42, std::next(view.begin(), 69)->value );
+
+    auto none = ni::views::of_type<H::B>(objects);
+    EXPECT_EQ( none.end(), none.begin() );
+
+    std::vector<H::A1 const*> empty;
+    EXPECT_EQ( ni::views::of_type<H::A>(empty).end(), ni::views::of_type<H::A>(empty).begin() );
+}
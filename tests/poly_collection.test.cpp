@@ -0,0 +1,199 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+#include <gtest/gtest.h>
+
+#include <ni/type_hierarchy/poly_collection.h>
+
+#include <memory>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct PolyCollectionTest : public ::testing::Test
+{
+    struct EventBase { virtual ~EventBase() = default; int counter = 0; };
+
+    using Event = ni::type_hierarchy::from_base<EventBase>;
+
+    struct MouseEvent : ni::sub_type<MouseEvent, Event>
+    {
+        MouseEvent(int x_ = 0, int y_ = 0) : x{x_}, y{y_} {}
+        int x, y;
+    };
+
+    struct MouseDown : ni::sub_type<MouseDown, MouseEvent>
+    {
+        MouseDown(int x_, int y_) { x = x_; y = y_; }
+    };
+
+    struct KeyEvent : ni::sub_type<KeyEvent, Event>
+    {
+        KeyEvent(char k) : key{k} {}
+        char key;
+    };
+
+    struct alignas(64) AlignedEvent : ni::sub_type<AlignedEvent, Event> {};
+
+    struct OwningEvent : ni::sub_type<OwningEvent, Event>
+    {
+        OwningEvent(int v) : value{std::make_unique<int>(v)} {}
+        std::unique_ptr<int> value;
+    };
+
+    ni::poly_collection<Event> events;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(PolyCollectionTest, objects_are_stored_per_type)
+{
+    auto& a = events.emplace<MouseEvent>(1, 2);
+    events.emplace<KeyEvent>('k');
+    auto& b = events.emplace<MouseEvent>(3, 4);
+
+    EXPECT_EQ( 3u, events.size() );
+    EXPECT_EQ( 2u, events.size<MouseEvent>() );
+    EXPECT_EQ( 1u, events.size<KeyEvent>() );
+    EXPECT_EQ( 0u, events.size<MouseDown>() );
+    EXPECT_EQ( &a + 1, &b );
+
+    std::vector<int> xs;
+    for (Event& e : events)
+        xs.push_back(ni::match(e)
+        (   [](MouseEvent& m) { return m.x; }
+        ,   [](KeyEvent& k) { return int(k.key); }
+        ,   [] { return 0; }
+        ));
+
+    EXPECT_EQ( (std::vector<int>{1, 3, 'k'}), xs );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(PolyCollectionTest, match_selects_case_per_segment)
+{
+    events.emplace<MouseEvent>(1, 2);
+    events.emplace<MouseDown>(3, 4);
+    events.emplace<KeyEvent>('k');
+    events.emplace<AlignedEvent>();
+    events.emplace<MouseDown>(5, 6);
+
+    int mouse = 0, key = 0, other = 0;
+    events.match
+    (   [&](MouseEvent const& m) { mouse += m.x; }
+    ,   [&](KeyEvent& k) { key += k.key; }
+    ,   [&] { ++other; }
+    );
+
+    EXPECT_EQ( 1 + 3 + 5, mouse );
+    EXPECT_EQ( 'k', key );
+    EXPECT_EQ( 1, other );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(PolyCollectionTest, match_with_case_table)
+{
+    struct TouchEvent : ni::sub_type<TouchEvent, Event> {};
+    struct WheelEvent : ni::sub_type<WheelEvent, Event> {};
+
+    events.emplace<MouseDown>(1, 2);
+    events.emplace<TouchEvent>();
+    events.emplace<WheelEvent>();
+    events.emplace<KeyEvent>('k');
+
+    std::vector<int> cases;
+    events.match
+    (   [&](MouseDown&) { cases.push_back(0); }
+    ,   [&](TouchEvent&) { cases.push_back(1); }
+    ,   [&](WheelEvent&) { cases.push_back(2); }
+    ,   [&](KeyEvent&) { cases.push_back(3); }
+    );
+
+    EXPECT_EQ( (std::vector<int>{0, 1, 2, 3}), cases );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(PolyCollectionTest, aligned_types_keep_their_alignment)
+{
+    events.reserve<AlignedEvent>(1);
+    EXPECT_EQ( 1u, events.capacity<AlignedEvent>() );
+
+    for (int n = 0; n < 10; ++n)
+        events.emplace<AlignedEvent>();
+
+    for (Event& e : events)
+        EXPECT_EQ( 0u, reinterpret_cast<std::uintptr_t>(ni::type_hierarchy_detail::dyn_cast<AlignedEvent>(&e)) % 64 );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(PolyCollectionTest, erase_if_keeps_order)
+{
+    for (int n = 0; n < 10; ++n)
+        events.emplace<OwningEvent>(n);
+    events.emplace<KeyEvent>('k');
+
+    auto erased = events.erase_if([](Event const& e)
+    {
+        auto* o = ni::type_hierarchy_detail::dyn_cast<OwningEvent>(&e);
+        return o and *o->value % 3 == 0;
+    });
+
+    EXPECT_EQ( 4u, erased );
+    EXPECT_EQ( 7u, events.size() );
+
+    std::vector<int> values;
+    events.match( [&](OwningEvent const& o) { values.push_back(*o.value); } );
+    EXPECT_EQ( (std::vector<int>{1, 2, 4, 5, 7, 8}), values );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(PolyCollectionTest, erase_moves_last_object_of_the_type)
+{
+    events.emplace<MouseEvent>(1, 0);
+    events.emplace<MouseEvent>(2, 0);
+    events.emplace<MouseEvent>(3, 0);
+    events.emplace<KeyEvent>('k');
+
+    auto it = events.erase(events.begin());
+    EXPECT_EQ( 3, static_cast<MouseEvent&>(*it).x );
+
+    std::vector<int> xs;
+    events.match( [&](MouseEvent& m) { xs.push_back(m.x); } );
+    EXPECT_EQ( (std::vector<int>{3, 2}), xs );
+    EXPECT_EQ( 3u, events.size() );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(PolyCollectionTest, copy_and_move)
+{
+    events.emplace<MouseEvent>(1, 2);
+    events.emplace<KeyEvent>('k');
+
+    auto copy = events;
+    EXPECT_EQ( 2u, copy.size() );
+    EXPECT_EQ( 2u, events.size() );
+
+    auto moved = std::move(copy);
+    EXPECT_EQ( 2u, moved.size() );
+
+    int sum = 0;
+    moved.for_each([&](Event& e) { sum += ni::match(e)( [](MouseEvent& m) { return m.x + m.y; }, [] { return 0; } ); });
+    EXPECT_EQ( 3, sum );
+
+    moved.clear();
+    EXPECT_TRUE( moved.empty() );
+    EXPECT_EQ( moved.begin(), moved.end() );
+}
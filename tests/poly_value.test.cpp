@@ -0,0 +1,199 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+#include <gtest/gtest.h>
+
+#include <ni/type_hierarchy/poly_value.h>
+#include <ni/functional/match.h>
+
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct PolyValueTest : public ::testing::Test
+{
+    struct EventBase { int counter = 0; };
+
+    using Event = ni::type_hierarchy::from_base<EventBase>;
+
+    struct MouseEvent : ni::sub_type<MouseEvent, Event>
+    {
+        MouseEvent(int x_ = 0, int y_ = 0) : x{x_}, y{y_} {}
+        int x, y;
+    };
+
+    struct MouseDown : ni::sub_type<MouseDown, MouseEvent>
+    {
+        MouseDown(int x_, int y_) { x = x_; y = y_; }
+    };
+
+    struct KeyEvent : ni::sub_type<KeyEvent, Event>
+    {
+        KeyEvent(char k) : key{k} {}
+        char key;
+    };
+
+    // the root is not at the start of the object
+    struct TextEvent : ni::sub_type<TextEvent, Event>
+    {
+        TextEvent(std::string t) : text{std::move(t)} {}
+        virtual std::string const& name() const { return text; }
+        std::string text;
+    };
+
+    struct OwningEvent : ni::sub_type<OwningEvent, Event>
+    {
+        OwningEvent(int v) : value{std::make_unique<int>(v)} {}
+        std::unique_ptr<int> value;
+    };
+
+    struct HugeEvent : ni::sub_type<HugeEvent, Event>
+    {
+        char data[256];
+    };
+
+    using event_value = ni::poly_value<Event, 48>;
+
+    static int classify(event_value const& e)
+    {
+        return ni::match(e)
+        (   [](MouseDown const&)  { return 2; }
+        ,   [](MouseEvent const&) { return 1; }
+        ,   [](KeyEvent const&)   { return 3; }
+        ,   [](TextEvent const&)  { return 4; }
+        ,   []                    { return 0; }
+        );
+    }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(PolyValueTest, stores_objects_inline)
+{
+    event_value e = MouseEvent{1, 2};
+    ASSERT_TRUE( e.has_value() );
+
+    auto const* address = reinterpret_cast<char const*>(e.get());
+    EXPECT_TRUE( address >= reinterpret_cast<char const*>(&e) );
+    EXPECT_TRUE( address < reinterpret_cast<char const*>(&e) + sizeof(e) );
+
+    EXPECT_TRUE( ni::convertible_to<MouseEvent>(*e) );
+    EXPECT_EQ( 2, static_cast<MouseEvent&>(*e).y );
+
+    e.emplace<KeyEvent>('k');
+    EXPECT_TRUE( ni::convertible_to<KeyEvent>(*e) );
+
+    e.reset();
+    EXPECT_FALSE( e.has_value() );
+    EXPECT_EQ( nullptr, e.get() );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(PolyValueTest, copies_and_moves_the_object)
+{
+    event_value a = TextEvent{"hello poly_value, this is longer than the small string"};
+    event_value b = a;
+
+    ASSERT_TRUE( b.has_value() );
+    EXPECT_NE( a.get(), b.get() );
+    EXPECT_EQ( "hello poly_value, this is longer than the small string", static_cast<TextEvent&>(*b).text );
+
+    event_value c = std::move(a);
+    EXPECT_FALSE( a.has_value() );
+    EXPECT_EQ( static_cast<TextEvent&>(*b).text, static_cast<TextEvent&>(*c).text );
+
+    c = MouseDown{3, 4};
+    b = c;
+    EXPECT_EQ( 4, static_cast<MouseEvent&>(*b).y );
+
+    event_value d;
+    d = std::move(b);
+    EXPECT_FALSE( b.has_value() );
+    EXPECT_EQ( 3, static_cast<MouseEvent&>(*d).x );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(PolyValueTest, move_only_types)
+{
+    event_value a;
+    a.emplace<OwningEvent>(42);
+
+    event_value b = std::move(a);
+    EXPECT_EQ( 42, *static_cast<OwningEvent&>(*b).value );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(PolyValueTest, match_on_values)
+{
+    std::vector<event_value> events;
+    events.emplace_back(MouseEvent{1, 2});
+    events.emplace_back(MouseDown{1, 2});
+    events.emplace_back(KeyEvent{'k'});
+    events.emplace_back(TextEvent{"text"});
+    events.emplace_back();
+
+    std::vector<int> classes;
+    for (auto const& e : events)
+        classes.push_back(classify(e));
+    EXPECT_EQ( (std::vector<int>{1, 2, 3, 4, 0}), classes );
+
+    auto key = ni::match(events[2])
+    (   [](KeyEvent& k) { return k.key; }
+    );
+    EXPECT_EQ( 'k', *key );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(PolyValueTest, vectors_of_values_grow_without_copies)
+{
+    std::vector<event_value> events;
+    for (int n = 0; n < 100; ++n)
+        events.emplace_back(OwningEvent{n});
+
+    for (int n = 0; n < 100; ++n)
+        EXPECT_EQ( n, *static_cast<OwningEvent&>(*events[std::size_t(n)]).value );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(PolyValueTest, trivial_copy_values_are_trivially_copyable)
+{
+    using trivial_value = ni::poly_value<Event, 16, ni::type_hierarchy::trivial_copy>;
+
+    static_assert( std::is_trivially_copyable<trivial_value>::value, "" );
+    static_assert( not std::is_trivially_copyable<event_value>::value, "" );
+
+    std::vector<trivial_value> events;
+    for (int n = 0; n < 100; ++n)
+        events.emplace_back(MouseEvent{n, n});
+    events.emplace_back(KeyEvent{'k'});
+
+    EXPECT_EQ( 99, static_cast<MouseEvent&>(*events[99]).x );
+    EXPECT_TRUE( ni::convertible_to<KeyEvent>(*events[100]) );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(PolyValueTest, capacity_is_checked_at_compile_time)
+{
+    static_assert( sizeof(HugeEvent) > event_value::capacity, "" );
+    static_assert( sizeof(ni::poly_value<Event, 512>) >= 512, "" );
+
+    ni::poly_value<Event, 512> huge;
+    huge.emplace<HugeEvent>();
+    EXPECT_TRUE( ni::convertible_to<HugeEvent>(*huge) );
+}
@@ -0,0 +1,166 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+#include <gtest/gtest.h>
+
+#include <ni/type_hierarchy/pool.h>
+
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct PoolTest : public ::testing::Test
+{
+    struct EventBase { int counter = 0; };
+
+    using Event = ni::type_hierarchy::from_base<EventBase>;
+
+    struct MouseEvent : ni::sub_type<MouseEvent, Event>
+    {
+        MouseEvent(int x_, int y_) : x{x_}, y{y_} {}
+        int x, y;
+    };
+
+    struct KeyEvent : ni::sub_type<KeyEvent, Event>
+    {
+        KeyEvent(char k, int* destroyed_) : key{k}, destroyed{destroyed_} {}
+        ~KeyEvent() { ++*destroyed; }
+        char key;
+        int* destroyed;
+    };
+
+    struct alignas(64) AlignedEvent : ni::sub_type<AlignedEvent, Event> {};
+
+    ni::type_hierarchy::pool<Event> pool;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(PoolTest, objects_of_one_type_are_contiguous)
+{
+    pool.reserve<MouseEvent>(3);
+
+    auto* a = pool.create<MouseEvent>(1, 2);
+    auto* b = pool.create<MouseEvent>(3, 4);
+    auto* c = pool.create<MouseEvent>(5, 6);
+
+    ASSERT_NE( nullptr, a );
+    ASSERT_NE( nullptr, b );
+    ASSERT_NE( nullptr, c );
+    EXPECT_EQ( 1, a->x );
+    EXPECT_EQ( 4, b->y );
+    EXPECT_EQ( a + 1, b );
+    EXPECT_EQ( b + 1, c );
+
+    pool.destroy(a);
+    pool.destroy(b);
+    pool.destroy(c);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(PoolTest, create_fails_if_slab_is_exhausted_or_not_reserved)
+{
+    pool.reserve<MouseEvent>(1);
+
+    int destroyed = 0;
+    EXPECT_EQ( nullptr, pool.create<KeyEvent>('k', &destroyed) );
+
+    auto* m = pool.create<MouseEvent>(1, 2);
+    EXPECT_NE( nullptr, m );
+    EXPECT_EQ( nullptr, pool.create<MouseEvent>(3, 4) );
+
+    pool.destroy(m);
+    m = pool.create<MouseEvent>(3, 4);
+    EXPECT_NE( nullptr, m );
+    pool.destroy(m);
+
+    pool.reserve<AlignedEvent>(0);
+    EXPECT_EQ( nullptr, pool.create<AlignedEvent>() );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(PoolTest, destroy_via_root_calls_destructor_of_concrete_type)
+{
+    pool.reserve<KeyEvent>(2);
+
+    int destroyed = 0;
+    Event* e = pool.create<KeyEvent>('k', &destroyed);
+    pool.destroy(e);
+
+    EXPECT_EQ( 1, destroyed );
+    EXPECT_EQ( 0u, pool.occupancy<KeyEvent>().used );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(PoolTest, occupancy_is_tracked_per_type)
+{
+    pool.reserve<MouseEvent>(4);
+    pool.reserve<AlignedEvent>(2);
+
+    auto* m1 = pool.create<MouseEvent>(1, 2);
+    auto* m2 = pool.create<MouseEvent>(1, 2);
+    auto* a1 = pool.create<AlignedEvent>();
+    pool.destroy(m1);
+
+    EXPECT_EQ( 0u, reinterpret_cast<std::uintptr_t>(a1) % 64 );
+
+    auto mo = pool.occupancy<MouseEvent>();
+    EXPECT_EQ( 4u, mo.capacity );
+    EXPECT_EQ( 1u, mo.used );
+    EXPECT_EQ( 2u, mo.peak );
+
+    auto all = pool.occupancies();
+    ASSERT_EQ( 2u, all.size() );
+    EXPECT_EQ( m2->type_hierarchy_id__(), all[0].id );
+    EXPECT_EQ( a1->type_hierarchy_id__(), all[1].id );
+    EXPECT_EQ( 1u, all[1].used );
+
+    EXPECT_EQ( 0u, pool.occupancy<KeyEvent>().capacity );
+
+    pool.destroy(m2);
+    pool.destroy(a1);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(PoolTest, concurrent_create_and_destroy)
+{
+    constexpr int num_threads = 4;
+    constexpr int num_iterations = 10000;
+
+    pool.reserve<MouseEvent>(num_threads * 2);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t)
+        threads.emplace_back([this, t]
+        {
+            for (int i = 0; i < num_iterations; ++i)
+            {
+                auto* a = pool.create<MouseEvent>(t, i);
+                auto* b = pool.create<MouseEvent>(i, t);
+                ASSERT_NE( nullptr, a );
+                ASSERT_NE( nullptr, b );
+                ASSERT_EQ( t, a->x );
+                ASSERT_EQ( t, b->y );
+                pool.destroy(a);
+                pool.destroy(b);
+            }
+        });
+
+    for (auto& t : threads)
+        t.join();
+
+    EXPECT_EQ( 0u, pool.occupancy<MouseEvent>().used );
+    EXPECT_GE( std::size_t(num_threads * 2), pool.occupancy<MouseEvent>().peak );
+}
@@ -0,0 +1,80 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+#include <gtest/gtest.h>
+
+#include <ni/type_hierarchy/registry.h>
+
+#include <algorithm>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace registry_test
+{
+    struct EventBase
+    {
+        using type_hierarchy_registry = ni::type_hierarchy::enable_registry;
+    };
+
+    using Event = ni::type_hierarchy::from_base<EventBase>;
+
+    struct MouseEvent : ni::sub_type<MouseEvent, Event> { int x, y; };
+    struct MouseDown : ni::sub_type<MouseDown, MouseEvent> { int button; };
+    struct KeyEvent : ni::sub_type<KeyEvent, Event> { char key; };
+    struct alignas(32) AlignedEvent : ni::sub_type<AlignedEvent, Event> {};
+}
+
+using namespace registry_test;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST(RegistryTest, types_of_the_hierarchy_are_registered)
+{
+    MouseDown m;
+    KeyEvent k;
+    AlignedEvent a;
+
+    using registry = ni::type_hierarchy::registry<Event>;
+
+    auto const* mouse_down = registry::find(m.type_hierarchy_id__());
+    ASSERT_NE( nullptr, mouse_down );
+    EXPECT_EQ( "registry_test::MouseDown", mouse_down->name );
+    EXPECT_EQ( sizeof(MouseDown), mouse_down->size );
+    EXPECT_EQ( 2, mouse_down->level );
+
+    auto const* mouse = registry::find(mouse_down->parent_id);
+    ASSERT_NE( nullptr, mouse );
+    EXPECT_EQ( "registry_test::MouseEvent", mouse->name );
+    EXPECT_EQ( 1, mouse->level );
+    EXPECT_EQ( 0u, mouse->parent_id );
+
+    auto const* aligned = registry::find(a.type_hierarchy_id__());
+    ASSERT_NE( nullptr, aligned );
+    EXPECT_EQ( 32u, aligned->alignment );
+
+    EXPECT_EQ( 4u, registry::types().size() );
+    EXPECT_EQ( nullptr, registry::find(0xff00) );
+    EXPECT_NE( nullptr, registry::find(k.type_hierarchy_id__()) );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST(RegistryTest, usage_of_levels)
+{
+    auto const levels = ni::type_hierarchy::registry<Event>::levels();
+
+    ASSERT_EQ( 4u, levels.size() );
+    EXPECT_EQ( 8, levels[0].bits );
+    EXPECT_EQ( 3u, levels[0].types );
+    EXPECT_EQ( 3u, levels[0].max_local_id );
+    EXPECT_EQ( 1u, levels[1].types );
+    EXPECT_EQ( 1u, levels[1].max_local_id );
+    EXPECT_EQ( 0u, levels[2].types );
+}
@@ -0,0 +1,211 @@
+//
+// MIT License
+//
+// Copyright © 2018
+// Native Instruments
+//
+// For more detailed information, please read the LICENSE in the root directory.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - >8
+
+#include <gtest/gtest.h>
+
+#include <ni/type_hierarchy/tagged_ptr.h>
+#include <ni/functional/match.h>
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace
+{
+    struct ShapeBase
+    {
+        int value = 0;
+    };
+
+    using Shape = ni::type_hierarchy::from_base<ShapeBase, 4, 4, 4, 4>;
+
+    struct Circle : ni::sub_type<Circle, Shape> {};
+    struct Polygon : ni::sub_type<Polygon, Shape> {};
+    struct Triangle : ni::sub_type<Triangle, Polygon> {};
+    struct Square : ni::sub_type<Square, Polygon> {};
+    struct Line : ni::sub_type<Line, Shape> {};
+
+    using shape_ptr = ni::type_hierarchy::tagged_ptr<Shape>;
+
+    int classify(shape_ptr p)
+    {
+        return ni::match(p)
+        (   [](Triangle&) { return 1; }
+        ,   [](Polygon&)  { return 2; }
+        ,   [](Circle&)   { return 3; }
+        ,   [](Line&)     { return 4; }
+        ,   []            { return 0; }
+        );
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST(TaggedPtrTest, stores_address_and_id)
+{
+    Triangle t;
+    shape_ptr p = &t;
+
+    EXPECT_EQ( sizeof(void*), sizeof(shape_ptr) );
+    EXPECT_EQ( static_cast<Shape*>(&t), p.get() );
+    EXPECT_EQ( t.type_hierarchy_id__(), p.id() );
+    EXPECT_TRUE( bool(p) );
+
+    p->value = 42;
+    EXPECT_EQ( 42, t.value );
+
+    shape_ptr null;
+    EXPECT_FALSE( bool(null) );
+    EXPECT_EQ( 0u, null.id() );
+    EXPECT_EQ( shape_ptr{nullptr}, null );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST(TaggedPtrTest, converts_to_handles_of_super_types)
+{
+    Square s;
+    ni::type_hierarchy::tagged_ptr<Polygon> polygon = &s;
+    shape_ptr shape = polygon;
+    ni::type_hierarchy::tagged_ptr<Shape const> const_shape = shape;
+
+    EXPECT_EQ( static_cast<Shape*>(&s), shape.get() );
+    EXPECT_EQ( s.type_hierarchy_id__(), shape.id() );
+    EXPECT_EQ( s.type_hierarchy_id__(), const_shape.id() );
+
+    static_assert( not std::is_convertible<shape_ptr, ni::type_hierarchy::tagged_ptr<Polygon>>::value, "" );
+    static_assert( not std::is_convertible<ni::type_hierarchy::tagged_ptr<Shape const>, shape_ptr>::value, "" );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST(TaggedPtrTest, convertible_to_uses_the_id_of_the_handle)
+{
+    Triangle t;
+    shape_ptr p = &t;
+
+    EXPECT_TRUE( ni::convertible_to<Triangle>(p) );
+    EXPECT_TRUE( ni::convertible_to<Polygon>(p) );
+    EXPECT_TRUE( ni::convertible_to<Shape>(p) );
+    EXPECT_TRUE( ni::convertible_to<ShapeBase>(p) );
+    EXPECT_FALSE( ni::convertible_to<Square>(p) );
+    EXPECT_FALSE( ni::convertible_to<Circle>(p) );
+    EXPECT_FALSE( ni::convertible_to<Shape>(shape_ptr{}) );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST(TaggedPtrTest, match_selects_the_case_via_the_id)
+{
+    Circle c; Triangle t; Square s; Line l;
+
+    EXPECT_EQ( 3, classify(&c) );
+    EXPECT_EQ( 1, classify(&t) );
+    EXPECT_EQ( 2, classify(&s) );
+    EXPECT_EQ( 4, classify(&l) );
+    EXPECT_EQ( 0, classify(nullptr) );
+
+    // few cases are tried one after another
+    ni::type_hierarchy::tagged_ptr<Shape const> p = &s;
+    auto const value = ni::match(p)
+    (   [](Circle const& x)  { return &x.value; }
+    ,   [](Polygon const& x) { return &x.value; }
+    );
+    EXPECT_EQ( &s.value, *value );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST(TaggedPtrTest, match_does_not_read_the_object)
+{
+    std::aligned_storage_t<sizeof(Square), alignof(Square)> storage;
+    auto* s = ::new (&storage) Square;
+    shape_ptr p = s;
+
+    // overwrite the id stored in the object
+    s->~Square();
+    std::memset(&storage, 0xff, sizeof(storage));
+
+    EXPECT_TRUE( ni::convertible_to<Square>(p) );
+    EXPECT_FALSE( ni::convertible_to<Triangle>(p) );
+    EXPECT_EQ( 2, classify(p) );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST(TaggedPtrTest, filter_vector_of_handles)
+{
+    std::vector<Circle> circles(3);
+    std::vector<Triangle> triangles(5);
+    std::vector<Square> squares(2);
+
+    std::vector<shape_ptr> shapes;
+    for (std::size_t i = 0; i < 5; ++i)
+    {
+        if (i < circles.size())   shapes.push_back(&circles[i]);
+        if (i < triangles.size()) shapes.push_back(&triangles[i]);
+        if (i < squares.size())   shapes.push_back(&squares[i]);
+    }
+
+    auto const polygons = std::count_if(shapes.begin(), shapes.end(), [](shape_ptr p)
+    {
+        return ni::convertible_to<Polygon>(p);
+    });
+    EXPECT_EQ( 7, polygons );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace
+{
+    struct Drawable
+    {
+        virtual ~Drawable() = default;
+        virtual int draw() const = 0;
+    };
+
+    struct WidgetBase
+    {
+        using type_hierarchy_interfaces = ni::meta::type_list<Drawable>;
+    };
+
+    using Widget = ni::type_hierarchy::from_base<WidgetBase, 4, 4>;
+
+    struct Label : ni::sub_type<Label, Widget>, Drawable
+    {
+        int draw() const override { return 1; }
+    };
+
+    struct Spacer : ni::sub_type<Spacer, Widget> {};
+}
+
+TEST(TaggedPtrTest, interfaces_are_read_from_the_object)
+{
+    Label l; Spacer s;
+    ni::type_hierarchy::tagged_ptr<Widget> label = &l, spacer = &s;
+
+    EXPECT_TRUE( ni::convertible_to<Drawable>(label) );
+    EXPECT_FALSE( ni::convertible_to<Drawable>(spacer) );
+    EXPECT_FALSE( ni::convertible_to<Drawable>(ni::type_hierarchy::tagged_ptr<Widget>{}) );
+
+    auto draw = [](ni::type_hierarchy::tagged_ptr<Widget> p)
+    {
+        return ni::match(p)
+        (   [](Drawable const& d) { return d.draw(); }
+        ,   []                    { return 0; }
+        );
+    };
+    EXPECT_EQ( 1, draw(label) );
+    EXPECT_EQ( 0, draw(spacer) );
+}
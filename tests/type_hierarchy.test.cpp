@@ -14,6 +14,9 @@
 #include <ni/functional/match.h>
 #include <ni/meta/try_catch.h>
 
+#include <algorithm>
+#include <memory>
+#include <thread>
 #include <vector>
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -341,3 +344,787 @@ TEST_F(TypeHierarchyTest, id_type_matches_provided_bits_per_level)
     Type4x16 t4x16;
     EXPECT_LE( 8u, sizeof(t4x16.type_hierarchy_id__()) );
 }
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(TypeHierarchyTest, wide_id_arithmetic)
+{
+    using id_t = ni::type_hierarchy_detail::wide_id<2>;
+
+    constexpr id_t one = 1;
+    constexpr id_t high = one << 100;
+    static_assert( high.words[0] == 0 and high.words[1] == (std::uint64_t(1) << 36), "" );
+    static_assert( (high >> 100) == one, "" );
+    static_assert( ((id_t{0xff} << 60) >> 60) == id_t{0xff}, "" );
+    static_assert( (high - one).words[0] == ~std::uint64_t(0), "" );
+    static_assert( ni::type_hierarchy_detail::low_bits<id_t>(70) == ((one << 70) - one), "" );
+    static_assert( ni::type_hierarchy_detail::low_bits<id_t>(128) == ~id_t{}, "" );
+    static_assert( (high | one) != high and ((high | one) & high) == high, "" );
+    static_assert( one < high and not (high < one), "" );
+
+    id_t const mask = ni::type_hierarchy_detail::low_bits<id_t>(100);
+    EXPECT_TRUE( ni::type_hierarchy_detail::equal_under_mask(high | id_t{42}, mask, id_t{42}) );
+    EXPECT_FALSE( ni::type_hierarchy_detail::equal_under_mask(high | id_t{42}, ~id_t{}, id_t{42}) );
+    EXPECT_FALSE( ni::type_hierarchy_detail::equal_under_mask((one << 99) | id_t{42}, mask, id_t{42}) );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace type_hierarchy_test_wide_ids
+{
+    struct WideBase {};
+
+    // 12 levels of 12 bits, 144 bit ids
+    using WideRoot = ni::type_hierarchy::from_base<WideBase, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12>;
+
+    struct NI_SUB_TYPE( W_1, WideRoot ) {};
+    struct NI_SUB_TYPE( W_2, W_1 ) {};
+    struct NI_SUB_TYPE( W_3, W_2 ) {};
+    struct NI_SUB_TYPE( W_4, W_3 ) {};
+    struct NI_SUB_TYPE( W_5, W_4 ) {};
+    struct NI_SUB_TYPE( W_6, W_5 ) {};
+    struct NI_SUB_TYPE( W_7, W_6 ) {};
+    struct NI_SUB_TYPE( W_8, W_7 ) {};
+    struct NI_SUB_TYPE( W_9, W_8 ) {};
+    struct NI_SUB_TYPE( W_10, W_9 ) {};
+    struct NI_SUB_TYPE( W_11, W_10 ) {};
+    struct NI_SUB_TYPE( W_12, W_11 ) {};
+    struct NI_SUB_TYPE( W_12b, W_11 ) {};
+    struct NI_SUB_TYPE( W_11b, W_10 ) {};
+
+    // 12 levels of 8 bits with static ids, 96 bit ids
+    using StaticWideRoot = ni::type_hierarchy::from_base<WideBase, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8>;
+
+    struct NI_SUB_TYPE( S_1, StaticWideRoot, ni::type_hierarchy::static_id<1> ) {};
+    struct NI_SUB_TYPE( S_2, S_1, ni::type_hierarchy::static_id<2> ) {};
+    struct NI_SUB_TYPE( S_3, S_2, ni::type_hierarchy::static_id<3> ) {};
+    struct NI_SUB_TYPE( S_4, S_3, ni::type_hierarchy::static_id<4> ) {};
+    struct NI_SUB_TYPE( S_5, S_4, ni::type_hierarchy::static_id<5> ) {};
+    struct NI_SUB_TYPE( S_6, S_5, ni::type_hierarchy::static_id<6> ) {};
+    struct NI_SUB_TYPE( S_7, S_6, ni::type_hierarchy::static_id<7> ) {};
+    struct NI_SUB_TYPE( S_8, S_7, ni::type_hierarchy::static_id<8> ) {};
+    struct NI_SUB_TYPE( S_9, S_8, ni::type_hierarchy::static_id<9> ) {};
+    struct NI_SUB_TYPE( S_10, S_9, ni::type_hierarchy::static_id<10> ) {};
+    struct NI_SUB_TYPE( S_10b, S_9, ni::type_hierarchy::static_id<11> ) {};
+    struct NI_SUB_TYPE( S_11, S_10, ni::type_hierarchy::static_id<12> ) {};
+    struct NI_SUB_TYPE( S_12, S_11, ni::type_hierarchy::static_id<13> ) {};
+}
+
+TEST_F(TypeHierarchyTest, ids_wider_than_64_bits)
+{
+    using namespace type_hierarchy_test_wide_ids;
+
+    static_assert( std::is_same< ni::type_hierarchy_detail::get_config_t<WideRoot>::id_t
+                               , ni::type_hierarchy_detail::wide_id<4> >::value, "" );
+
+    W_12   w_12;
+    W_12b  w_12b;
+    W_11b  w_11b;
+    EXPECT_NE( w_12.type_hierarchy_id__(), w_12b.type_hierarchy_id__() );
+
+    WideRoot* r = &w_12;
+    EXPECT_TRUE( ni::convertible_to<W_1>(*r) );
+    EXPECT_TRUE( ni::convertible_to<W_6>(*r) );
+    EXPECT_TRUE( ni::convertible_to<W_11>(*r) );
+    EXPECT_TRUE( ni::convertible_to<W_12>(*r) );
+    EXPECT_FALSE( ni::convertible_to<W_12b>(*r) );
+    EXPECT_FALSE( ni::convertible_to<W_11b>(*r) );
+
+    r = &w_11b;
+    EXPECT_TRUE( ni::convertible_to<W_10>(*r) );
+    EXPECT_FALSE( ni::convertible_to<W_11>(*r) );
+    EXPECT_EQ( nullptr, ni::type_hierarchy_detail::dyn_cast<W_12>(r) );
+    EXPECT_EQ( &w_11b, ni::type_hierarchy_detail::dyn_cast<W_11b>(r) );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(TypeHierarchyTest, static_wide_ids_and_case_tables)
+{
+    using namespace type_hierarchy_test_wide_ids;
+
+    using id_t = ni::type_hierarchy_detail::get_config_t<StaticWideRoot>::id_t;
+    static_assert( std::is_same<id_t, ni::type_hierarchy_detail::wide_id<2>>::value, "" );
+    static_assert( ni::type_hierarchy::id_v<S_12> == ((ni::type_hierarchy::id_v<S_11>) | (id_t{13} << 88)), "" );
+    static_assert( (ni::type_hierarchy::id_v<S_12> >> 88) == id_t{13}, "" );
+
+    S_12   s_12;
+    S_10b  s_10b;
+    S_8    s_8;
+
+    auto classify = [](StaticWideRoot const& r)
+    {
+        return ni::match(r)
+        (   [](S_12 const&)   { return 12; }
+        ,   [](S_10b const&)  { return 10; }
+        ,   [](S_9 const&)    { return 9; }
+        ,   [](S_1 const&)    { return 1; }
+        ,   []                { return 0; }
+        );
+    };
+
+    EXPECT_EQ( 12, classify(s_12) );
+    EXPECT_EQ( 10, classify(s_10b) );
+    EXPECT_EQ( 1, classify(s_8) );
+    EXPECT_TRUE( ni::convertible_to<S_10>(s_12) );
+    EXPECT_FALSE( ni::convertible_to<S_10b>(s_12) );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(TypeHierarchyTest, shape_selects_minimal_bits_per_level)
+{
+    using ni::type_hierarchy_detail::bits_for_types;
+    static_assert( bits_for_types(1) == 1, "" );
+    static_assert( bits_for_types(3) == 2, "" );
+    static_assert( bits_for_types(4) == 3, "" );
+    static_assert( bits_for_types(255) == 8, "" );
+    static_assert( bits_for_types(256) == 9, "" );
+
+    struct Base {};
+
+    using Root = ni::type_hierarchy::from_shape<Base, 3, 4, 1>;
+    using config_t = ni::type_hierarchy_detail::get_config_t<Root>;
+    static_assert( std::is_same<config_t::bits_per_level, std::integer_sequence<int, 2, 3, 1>>::value, "" );
+    static_assert( std::is_same<config_t::id_t, std::uint8_t>::value, "" );
+
+    struct NI_SUB_TYPE( A, Root ) {};
+    struct NI_SUB_TYPE( B, Root ) {};
+    struct NI_SUB_TYPE( C, Root ) {};
+    struct NI_SUB_TYPE( A_1, A ) {};
+    struct NI_SUB_TYPE( A_2, A ) {};
+    struct NI_SUB_TYPE( B_1, B ) {};
+    struct NI_SUB_TYPE( C_1, C ) {};
+    struct NI_SUB_TYPE( C_1_1, C_1 ) {};
+
+    A_2 a_2;
+    C_1 c_1;
+    C_1_1 c_1_1;
+    Root& r = c_1_1;
+    EXPECT_EQ( 1u, sizeof(r.type_hierarchy_id__()) );
+    EXPECT_TRUE( ni::convertible_to<C_1>(r) );
+    EXPECT_FALSE( ni::convertible_to<B_1>(r) );
+    EXPECT_FALSE( ni::convertible_to<A_1>(a_2) );
+    EXPECT_NE( a_2.type_hierarchy_id__(), c_1.type_hierarchy_id__() );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace type_hierarchy_test_static_ids
+{
+    struct StaticBase {};
+
+    using StaticRoot = ni::type_hierarchy::from_base<StaticBase>;
+
+    struct S_1 : ni::sub_type<S_1, StaticRoot, ni::type_hierarchy::static_id<1>> {};
+    struct S_2 : ni::sub_type<S_2, StaticRoot, ni::type_hierarchy::static_id<2>> {};
+    struct NI_SUB_TYPE( S_1_1, S_1, ni::type_hierarchy::static_id<1> ) {};
+    struct NI_SUB_TYPE( S_1_2, S_1, ni::type_hierarchy::static_id<2> ) {};
+    struct NI_SUB_TYPE( S_2_1, S_2, ni::type_hierarchy::static_id<1> ) {};
+    struct NI_SUB_TYPE( S_2_1_d, S_2_1 ) {};   // dynamic ids may be used below static ids
+
+    int classify(StaticRoot const& r)
+    {
+        switch (r.type_hierarchy_id__())
+        {
+            case ni::type_hierarchy::id_v<S_1>:   return 1;
+            case ni::type_hierarchy::id_v<S_1_1>: return 11;
+            case ni::type_hierarchy::id_v<S_1_2>: return 12;
+            case ni::type_hierarchy::id_v<S_2>:   return 2;
+            case ni::type_hierarchy::id_v<S_2_1>: return 21;
+            default:                              return 0;
+        }
+    }
+}
+
+TEST_F(TypeHierarchyTest, static_ids_are_compile_time_constants)
+{
+    using namespace type_hierarchy_test_static_ids;
+
+    static_assert( ni::type_hierarchy::id_v<S_1> == 1u, "" );
+    static_assert( ni::type_hierarchy::id_v<S_2> == 2u, "" );
+    static_assert( ni::type_hierarchy::id_v<S_1_1> == (1u | (1u << 8)), "" );
+    static_assert( ni::type_hierarchy::id_v<S_1_2> == (1u | (2u << 8)), "" );
+    static_assert( ni::type_hierarchy::id_v<S_2_1> == (2u | (1u << 8)), "" );
+
+    S_1_2 s_1_2;
+    S_2_1 s_2_1;
+    EXPECT_EQ( ni::type_hierarchy::id_v<S_1_2>, s_1_2.type_hierarchy_id__() );
+    EXPECT_EQ( 12, classify(s_1_2) );
+    EXPECT_EQ( 21, classify(s_2_1) );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(TypeHierarchyTest, static_ids_are_convertible_along_the_hierarchy)
+{
+    using namespace type_hierarchy_test_static_ids;
+
+    S_1_1    s_1_1;
+    S_2_1_d  s_2_1_d;
+
+    StaticRoot* r = &s_1_1;
+    EXPECT_TRUE( ni::convertible_to<S_1>(*r) );
+    EXPECT_TRUE( ni::convertible_to<S_1_1>(*r) );
+    EXPECT_FALSE( ni::convertible_to<S_1_2>(*r) );
+    EXPECT_FALSE( ni::convertible_to<S_2>(*r) );
+
+    r = &s_2_1_d;
+    EXPECT_TRUE( ni::convertible_to<S_2>(*r) );
+    EXPECT_TRUE( ni::convertible_to<S_2_1>(*r) );
+    EXPECT_TRUE( ni::convertible_to<S_2_1_d>(*r) );
+    EXPECT_FALSE( ni::convertible_to<S_1>(*r) );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace type_hierarchy_test_hashed_ids
+{
+    struct HashedBase {};
+
+    using HashedRoot = ni::type_hierarchy::from_base<HashedBase, 16, 16, 16>;
+
+    struct H_1 : ni::sub_type<H_1, HashedRoot, ni::type_hierarchy::hashed_id<>> {};
+    struct H_2 : ni::sub_type<H_2, HashedRoot, ni::type_hierarchy::hashed_id<>> {};
+    struct NI_SUB_TYPE( H_1_1, H_1, ni::type_hierarchy::hashed_id<> ) {};
+    struct NI_SUB_TYPE( H_1_2, H_1, ni::type_hierarchy::hashed_id<7> ) {};
+    struct NI_SUB_TYPE( H_1_2_d, H_1_2 ) {};   // dynamic ids may be used below hashed ids
+
+    template <typename T, std::uint64_t Salt>
+    constexpr std::uint64_t expected_local_id()
+    {
+        using namespace ni::type_hierarchy_detail;
+        return hash_name(type_name<T>(), Salt) % 0xffff + 1;
+    }
+}
+
+TEST_F(TypeHierarchyTest, hashed_ids_are_derived_from_the_type_name)
+{
+    using namespace type_hierarchy_test_hashed_ids;
+    using ni::type_hierarchy_detail::type_name;
+
+    static_assert( type_name<H_1_1>() == type_name<H_1_1>(), "" );
+    EXPECT_EQ( "type_hierarchy_test_hashed_ids::H_1_1", std::string(type_name<H_1_1>().data, type_name<H_1_1>().size) );
+
+    static_assert( ni::type_hierarchy::id_v<H_1> == expected_local_id<H_1, 0>(), "" );
+    static_assert( ni::type_hierarchy::id_v<H_2> == expected_local_id<H_2, 0>(), "" );
+    static_assert( ni::type_hierarchy::id_v<H_1_1> == (expected_local_id<H_1, 0>() | (expected_local_id<H_1_1, 0>() << 16)), "" );
+    static_assert( ni::type_hierarchy::id_v<H_1_2> == (expected_local_id<H_1, 0>() | (expected_local_id<H_1_2, 7>() << 16)), "" );
+    static_assert( expected_local_id<H_1_2, 7>() != expected_local_id<H_1_2, 0>(), "the salt must change the id" );
+
+    H_1_1 h_1_1;
+    EXPECT_EQ( ni::type_hierarchy::id_v<H_1_1>, h_1_1.type_hierarchy_id__() );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(TypeHierarchyTest, hashed_ids_are_convertible_along_the_hierarchy)
+{
+    using namespace type_hierarchy_test_hashed_ids;
+
+    H_1_1    h_1_1;
+    H_1_2_d  h_1_2_d;
+
+    HashedRoot* r = &h_1_1;
+    EXPECT_TRUE( ni::convertible_to<H_1>(*r) );
+    EXPECT_TRUE( ni::convertible_to<H_1_1>(*r) );
+    EXPECT_FALSE( ni::convertible_to<H_1_2>(*r) );
+    EXPECT_FALSE( ni::convertible_to<H_2>(*r) );
+
+    r = &h_1_2_d;
+    EXPECT_TRUE( ni::convertible_to<H_1>(*r) );
+    EXPECT_TRUE( ni::convertible_to<H_1_2>(*r) );
+    EXPECT_TRUE( ni::convertible_to<H_1_2_d>(*r) );
+    EXPECT_FALSE( ni::convertible_to<H_1_1>(*r) );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(TypeHierarchyTest, released_dynamic_ids_are_reused)
+{
+    struct PluginBase {};
+
+    using PluginRoot = ni::type_hierarchy::from_base<PluginBase>;
+    using config_t = ni::type_hierarchy_detail::get_config_t<PluginRoot>;
+    using lease_t = ni::type_hierarchy_detail::id_lease<config_t, 0>;
+
+    struct NI_SUB_TYPE( P_1, PluginRoot ) {};
+    P_1 p_1;
+    EXPECT_EQ( 1u, p_1.type_hierarchy_id__() );
+
+    auto plugin = std::make_unique<lease_t>();
+    EXPECT_EQ( 2u, plugin->local_id );
+    plugin.reset();
+
+    lease_t reloaded;
+    lease_t other;
+    EXPECT_EQ( 2u, reloaded.local_id );
+    EXPECT_EQ( 3u, other.local_id );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(TypeHierarchyTest, dynamic_ids_can_be_assigned_concurrently)
+{
+    struct ConcurrentBase {};
+
+    using ConcurrentRoot = ni::type_hierarchy::from_base<ConcurrentBase, 16>;
+    using config_t = ni::type_hierarchy_detail::get_config_t<ConcurrentRoot>;
+    using allocator_t = ni::type_hierarchy_detail::id_allocator<config_t, 0>;
+
+    constexpr int num_threads = 4;
+    constexpr int ids_per_thread = 1000;
+
+    std::vector<std::vector<config_t::id_t>> ids(num_threads);
+    std::vector<std::thread> threads;
+    for (auto& thread_ids : ids)
+        threads.emplace_back([&thread_ids]
+        {
+            for (int i = 0; i < ids_per_thread; ++i)
+                thread_ids.push_back(allocator_t::instance().acquire());
+        });
+    for (auto& thread : threads)
+        thread.join();
+
+    std::vector<config_t::id_t> all;
+    for (auto const& thread_ids : ids)
+        all.insert(all.end(), thread_ids.begin(), thread_ids.end());
+    std::sort(all.begin(), all.end());
+    EXPECT_EQ( all.end(), std::adjacent_find(all.begin(), all.end()) );
+    EXPECT_EQ( std::size_t(num_threads * ids_per_thread), all.size() );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(TypeHierarchyTest, full_width_ids_are_masked_correctly)
+{
+    struct WideBase {};
+
+    using WideRoot = ni::type_hierarchy::from_base<WideBase, 32, 32>;
+
+    struct NI_SUB_TYPE( W_1, WideRoot ) {};
+    struct NI_SUB_TYPE( W_2, WideRoot ) {};
+    struct NI_SUB_TYPE( W_1_1, W_1 ) {};
+    struct NI_SUB_TYPE( W_1_2, W_1 ) {};
+
+    W_1_1 w_1_1;
+    WideRoot& r = w_1_1;
+    EXPECT_TRUE( ni::convertible_to<W_1>(r) );
+    EXPECT_FALSE( ni::convertible_to<W_2>(r) );
+    EXPECT_TRUE( ni::convertible_to<W_1_1>(r) );
+    EXPECT_FALSE( ni::convertible_to<W_1_2>(r) );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(TypeHierarchyTest, case_table_selects_first_matching_case)
+{
+    using targets = ni::meta::type_list<Type_1_1, Type_2, Type_1, Type_1_1_1, TestHierarchyBase>;
+
+    EXPECT_EQ( 0u, dyn_case(targets{}, static_cast<Root const*>(&x_1_1)) );
+    EXPECT_EQ( 0u, dyn_case(targets{}, static_cast<Root const*>(&x_1_1_1)) );   // shadowed by Type_1_1
+    EXPECT_EQ( 0u, dyn_case(targets{}, static_cast<Root const*>(&x_1_1_2)) );
+    EXPECT_EQ( 1u, dyn_case(targets{}, static_cast<Root const*>(&x_2_1)) );
+    EXPECT_EQ( 2u, dyn_case(targets{}, static_cast<Root const*>(&x_1)) );
+    EXPECT_EQ( 2u, dyn_case(targets{}, static_cast<Root const*>(&x_1_2)) );
+
+    using no_base = ni::meta::type_list<Type_1_1_2, Type_2_2, Type_1_2, Type_1_1>;
+
+    EXPECT_EQ( 0u, dyn_case(no_base{}, static_cast<Root const*>(&x_1_1_2)) );
+    EXPECT_EQ( 1u, dyn_case(no_base{}, static_cast<Root const*>(&x_2_2)) );
+    EXPECT_EQ( 3u, dyn_case(no_base{}, static_cast<Root const*>(&x_1_1_1)) );
+    EXPECT_EQ( 4u, dyn_case(no_base{}, static_cast<Root const*>(&x_1)) );
+    EXPECT_EQ( 4u, dyn_case(no_base{}, static_cast<Root const*>(&x_2_1)) );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(TypeHierarchyTest, match_with_case_table_keeps_first_match_semantics)
+{
+    std::vector<Root*>  ptrs     = {&x_1, &x_1_1, &x_1_2, &x_1_1_1, &x_1_1_2, &x_2, &x_2_1, &x_2_2};
+    std::vector<int>    expected = {   1,     11,      1,      111,       11,    2,     2,    -1};
+    std::vector<int>    matches;
+
+    auto m = ni::matcher
+    (   [](Type_1_1_1 const&) { return 111; }
+    ,   [](Type_1_1 const&)   { return 11; }
+    ,   [](Type_1 const&)     { return 1; }
+    ,   [](Type_1_2 const&)   { return 12; }      // shadowed by Type_1
+    ,   [](Type_2_1 const&)   { return 2; }
+    ,   [](Type_2 const& x)   { return convertible_to<Type_2_2>(&x) ? -1 : 2; }
+    );
+
+    for (Root* p : ptrs)
+        matches.push_back(*m(*p));
+
+    EXPECT_EQ( expected, matches );
+
+    Root const& cr = x_2;
+    EXPECT_EQ( 2, *m(cr) );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(TypeHierarchyTest, match_with_case_table_on_deep_and_static_hierarchies)
+{
+    struct DeepBase {};
+
+    using DeepRoot = ni::type_hierarchy::from_base<DeepBase, 2, 2, 2, 2>;
+
+    struct NI_SUB_TYPE( D_1, DeepRoot, ni::type_hierarchy::static_id<1> ) {};
+    struct NI_SUB_TYPE( D_2, DeepRoot, ni::type_hierarchy::static_id<2> ) {};
+    struct NI_SUB_TYPE( D_3, DeepRoot, ni::type_hierarchy::static_id<3> ) {};
+    struct NI_SUB_TYPE( D_1_1, D_1, ni::type_hierarchy::static_id<1> ) {};
+    struct NI_SUB_TYPE( D_1_1_1, D_1_1, ni::type_hierarchy::static_id<1> ) {};
+    struct NI_SUB_TYPE( D_1_1_1_3, D_1_1_1, ni::type_hierarchy::static_id<3> ) {};
+
+    D_1 d_1;  D_2 d_2;  D_3 d_3;  D_1_1 d_1_1;  D_1_1_1_3 d_1_1_1_3;
+
+    auto m = ni::matcher
+    (   [](D_1_1_1_3&) { return 1113; }
+    ,   [](D_2&)       { return 2; }
+    ,   [](D_1_1&)     { return 11; }
+    ,   [](D_1&)       { return 1; }
+    ,   ni::otherwise(0)
+    );
+
+    EXPECT_EQ( 1113, m(static_cast<DeepRoot&>(d_1_1_1_3)) );
+    EXPECT_EQ( 11, m(static_cast<DeepRoot&>(d_1_1)) );
+    EXPECT_EQ( 1, m(static_cast<DeepRoot&>(d_1)) );
+    EXPECT_EQ( 2, m(static_cast<DeepRoot&>(d_2)) );
+    EXPECT_EQ( 0, m(static_cast<DeepRoot&>(d_3)) );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(TypeHierarchyTest, dyn_cast_from_any_level_to_any_level)
+{
+    using ni::type_hierarchy_detail::dyn_cast;
+
+    Root* r = &x_1_1_1;
+    EXPECT_EQ( &x_1_1_1, dyn_cast<Type_1_1_1>(r) );
+    EXPECT_EQ( nullptr, dyn_cast<Type_1_1_2>(r) );
+
+    Type_1* t1 = &x_1_1_1;
+    EXPECT_EQ( &x_1_1_1, dyn_cast<Type_1_1>(t1) );
+    EXPECT_EQ( &x_1_1_1, dyn_cast<Type_1_1_1>(t1) );
+    EXPECT_EQ( nullptr, dyn_cast<Type_1_2>(t1) );
+    EXPECT_EQ( nullptr, dyn_cast<Type_2>(t1) );          // sibling branch, decided at compile time
+    EXPECT_EQ( nullptr, dyn_cast<Type_2_1>(t1) );
+
+    Type_1_1_2* t112 = &x_1_1_2;
+    EXPECT_EQ( static_cast<Type_1*>(&x_1_1_2), dyn_cast<Type_1>(t112) );      // up-cast
+    EXPECT_EQ( static_cast<Root*>(&x_1_1_2), dyn_cast<Root>(t112) );
+    EXPECT_EQ( nullptr, dyn_cast<Type_1_2>(t112) );
+    EXPECT_EQ( nullptr, dyn_cast<Type_2>(t112) );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(TypeHierarchyTest, dyn_cast_propagates_constness)
+{
+    using ni::type_hierarchy_detail::dyn_cast;
+
+    Type_1_1 const* c = &x_1_1;
+    Type_1_1* nc = &x_1_1;
+
+    static_assert( std::is_same<Type_1 const*, decltype(dyn_cast<Type_1>(c))>::value, "" );
+    static_assert( std::is_same<Type_1_2 const*, decltype(dyn_cast<Type_1_2>(c))>::value, "" );
+    static_assert( std::is_same<Type_1 const*, decltype(dyn_cast<Type_1 const>(nc))>::value, "" );
+    static_assert( std::is_same<Type_1_1_1*, decltype(dyn_cast<Type_1_1_1>(nc))>::value, "" );
+
+    EXPECT_EQ( &x_1_1, dyn_cast<Type_1_1 const>(static_cast<Root const*>(c)) );
+    EXPECT_EQ( nullptr, dyn_cast<Type_1_1_1>(c) );
+    EXPECT_EQ( nullptr, dyn_cast<Type_2 const>(c) );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(TypeHierarchyTest, match_on_intermediate_levels)
+{
+    std::vector<Type_1*>     ptrs             = {&x_1, &x_1_1, &x_1_2, &x_1_1_1, &x_1_1_2};
+    std::vector<std::string> expected_matches = {  "1",  "1_1",  "1_2",  "1_1_1",  "1_1"};
+    std::vector<std::string> matches;
+
+    for (Type_1 const* p : ptrs)
+    {
+        matches.push_back
+        (   *ni::match(*p)
+            (   [](Type_2 const&)     { return std::string("2"); }
+            ,   [](Type_1_1_1 const&) { return std::string("1_1_1"); }
+            ,   [](Type_2_1 const&)   { return std::string("2_1"); }
+            ,   [](Type_1_1 const&)   { return std::string("1_1"); }
+            ,   [](Type_1_2 const&)   { return std::string("1_2"); }
+            ,   [](Type_1 const&)     { return std::string("1"); }
+            )
+        );
+    }
+
+    EXPECT_EQ( expected_matches, matches );
+
+    Type_2_2 const& t22 = x_2_2;
+    EXPECT_FALSE( ni::match(t22)([](Type_1 const&){}) );
+    EXPECT_TRUE( ni::match(t22)([](Type_2 const&){}) );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(TypeHierarchyTest, match_drops_cases_on_other_branches)
+{
+    using ni::detail::static_case_t;
+
+    static_assert( std::is_same<static_case_t<Type_2, Type_1_1>, ni::detail::never_matches>::value, "" );
+    static_assert( std::is_same<static_case_t<Type_1 const, Type_1_1 const>, ni::detail::always_matches>::value, "" );
+    static_assert( std::is_same<static_case_t<Type_1_1, Type_1>, ni::detail::may_match>::value, "" );
+
+    Type_1_1 const& t11 = x_1_1_2;
+    EXPECT_EQ( "1", *ni::match(t11)
+    (   [](Type_2 const&)     { return std::string("2"); }
+    ,   [](Type_2_1 const&)   { return std::string("2_1"); }
+    ,   [](Type_1 const&)     { return std::string("1"); }
+    ,   [](Type_1_1_2 const&) { return std::string("1_1_2"); }
+    ));
+
+    EXPECT_EQ( "1_1_2", *ni::match(t11)
+    (   [](Type_2 const&)     { return std::string("2"); }
+    ,   [](Type_1_1_2 const&) { return std::string("1_1_2"); }
+    ,   [](Type_1 const&)     { return std::string("1"); }
+    ));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(TypeHierarchyTest, match_pairs_selects_most_specific_case)
+{
+    auto f = ni::matcher
+    (   [](Root const&, Root const&)        { return 0; }
+    ,   [](Type_1 const&, Type_2 const&)    { return 1; }
+    ,   [](Type_1_1 const&, Type_2 const&)  { return 2; }
+    ,   [](Type_1 const&, Type_2_1 const&)  { return 3; }
+    ,   [](Type_1_1_1 const&, Root const&)  { return 4; }
+    ,   [](Type_2 const&, Type_1 const&)    { return 5; }
+    );
+
+    auto check = [&](Root const& a, Root const& b) { return f(a, b).value(); };
+
+    EXPECT_EQ( 0, check(x_1, x_1) );
+    EXPECT_EQ( 1, check(x_1, x_2) );
+    EXPECT_EQ( 1, check(x_1_2, x_2_2) );
+    EXPECT_EQ( 2, check(x_1_1, x_2) );
+    EXPECT_EQ( 2, check(x_1_1_2, x_2_2) );
+    EXPECT_EQ( 3, check(x_1, x_2_1) );
+    EXPECT_EQ( 2, check(x_1_1, x_2_1) );    // same rank as case 3, the first one wins
+    EXPECT_EQ( 2, check(x_1_1_1, x_2) );    // same rank as case 4
+    EXPECT_EQ( 4, check(x_1_1_1, x_1) );
+    EXPECT_EQ( 5, check(x_2_2, x_1_1_1) );
+    EXPECT_EQ( 0, check(x_2, x_2) );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(TypeHierarchyTest, match_pairs_without_default)
+{
+    Root& a = x_1_1;
+    Root& b = x_2_2;
+
+    std::vector<int> cases;
+    EXPECT_TRUE( ni::match(a, b)
+    (   [&](Type_1_1& , Type_2_2& ) { cases.push_back(1); }
+    ,   [&](Type_2&   , Type_1&   ) { cases.push_back(2); }
+    ));
+    EXPECT_FALSE( ni::match(b, a)
+    (   [&](Type_1_1& , Type_2_2& ) { cases.push_back(1); }
+    ,   [&](Type_2_1& , Type_1&   ) { cases.push_back(2); }
+    ));
+
+    EXPECT_EQ( std::vector<int>{1}, cases );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace type_hierarchy_test_interfaces
+{
+    struct Undoable
+    {
+        virtual ~Undoable() = default;
+        virtual int undo() = 0;
+    };
+
+    struct Serializable
+    {
+        virtual ~Serializable() = default;
+        virtual int serialize() const = 0;
+    };
+
+    struct Unused {};
+
+    struct InterfaceBase
+    {
+        using type_hierarchy_interfaces = ni::meta::type_list<Unused, Undoable, Serializable>;
+    };
+
+    using Command = ni::type_hierarchy::from_base<InterfaceBase>;
+
+    struct NI_SUB_TYPE( Insert, Command ), Undoable
+    {
+        int undo() override { return 1; }
+    };
+
+    struct Delete : Serializable, ni::sub_type<Delete, Command>, Undoable
+    {
+        int undo() override { return 2; }
+        int serialize() const override { return 20; }
+    };
+
+    struct NI_SUB_TYPE( DeleteAll, Delete )
+    {
+        int undo() override { return 3; }
+    };
+
+    struct NI_SUB_TYPE( Quit, Command ) {};
+}
+
+TEST_F(TypeHierarchyTest, interfaces_are_tested_via_bits)
+{
+    using namespace type_hierarchy_test_interfaces;
+
+    Insert     insert;
+    Delete     del;
+    DeleteAll  delete_all;
+    Quit       quit;
+
+    EXPECT_TRUE( ni::convertible_to<Undoable>(static_cast<Command&>(insert)) );
+    EXPECT_FALSE( ni::convertible_to<Serializable>(static_cast<Command&>(insert)) );
+    EXPECT_TRUE( ni::convertible_to<Undoable>(static_cast<Command&>(del)) );
+    EXPECT_TRUE( ni::convertible_to<Serializable const>(static_cast<Command const&>(delete_all)) );
+    EXPECT_FALSE( ni::convertible_to<Undoable>(static_cast<Command&>(quit)) );
+    EXPECT_FALSE( ni::convertible_to<Unused>(static_cast<Command&>(del)) );
+
+    // interfaces are not part of the id, types without them keep their size
+    EXPECT_EQ( insert.type_hierarchy_id__() & 0xff, insert.type_hierarchy_id__() );
+    static_assert( sizeof(ni::type_hierarchy::from_base<Unused>) == sizeof(std::uint32_t), "" );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(TypeHierarchyTest, dyn_cast_to_interfaces_adjusts_the_address)
+{
+    using namespace type_hierarchy_test_interfaces;
+
+    Delete     del;
+    DeleteAll  delete_all;
+    Quit       quit;
+
+    Command* c = &del;
+    EXPECT_EQ( static_cast<Undoable*>(&del), ni::type_hierarchy_detail::dyn_cast<Undoable>(c) );
+    EXPECT_EQ( static_cast<Serializable*>(&del), ni::type_hierarchy_detail::dyn_cast<Serializable>(c) );
+
+    c = &delete_all;
+    EXPECT_EQ( 3, ni::type_hierarchy_detail::dyn_cast<Undoable>(c)->undo() );
+
+    Command const* cc = &delete_all;
+    Serializable const* s = ni::type_hierarchy_detail::dyn_cast<Serializable>(cc);
+    EXPECT_EQ( static_cast<Serializable const*>(&delete_all), s );
+
+    c = &quit;
+    EXPECT_EQ( nullptr, ni::type_hierarchy_detail::dyn_cast<Undoable>(c) );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+TEST_F(TypeHierarchyTest, match_on_interfaces)
+{
+    using namespace type_hierarchy_test_interfaces;
+
+    Insert     insert;
+    Delete     del;
+    DeleteAll  delete_all;
+    Quit       quit;
+
+    auto f = [](Command& c)
+    {
+        return ni::match(c)
+        (   [](DeleteAll& x)           { return 100 + x.undo(); }
+        ,   [](Serializable const& x)  { return x.serialize(); }
+        ,   [](Undoable& x)            { return x.undo(); }
+        ,   [](Quit&)                  { return -1; }
+        ,   []                         { return 0; }
+        );
+    };
+
+    EXPECT_EQ( 1, f(insert) );
+    EXPECT_EQ( 20, f(del) );
+    EXPECT_EQ( 103, f(delete_all) );
+    EXPECT_EQ( -1, f(quit) );
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace type_hierarchy_test_closed
+{
+    struct EventBase {};
+
+    using Event = ni::type_hierarchy::from_base<EventBase>;
+
+    struct NI_SUB_TYPE( MouseEvent, Event ) {};
+    struct NI_SUB_TYPE( MouseUp, MouseEvent ) {};
+    struct NI_SUB_TYPE( MouseDown, MouseEvent ) {};
+    struct NI_SUB_TYPE( KeyEvent, Event ) {};
+
+    ni::type_hierarchy::closed<Event, MouseUp, MouseDown, KeyEvent> type_hierarchy_closed(Event const*);
+
+    // not closed
+    struct OpenBase {};
+    using Open = ni::type_hierarchy::from_base<OpenBase>;
+    struct NI_SUB_TYPE( OpenChild, Open ) {};
+}
+
+TEST_F(TypeHierarchyTest, exhaustive_matches_on_closed_hierarchies_return_plain_results)
+{
+    using namespace type_hierarchy_test_closed;
+
+    MouseUp    up;
+    MouseDown  down;
+    KeyEvent   key;
+
+    auto exhaustive = ni::matcher
+    (   [](MouseDown const&)  { return 1; }
+    ,   [](MouseEvent const&) { return 2; }
+    ,   [](KeyEvent const&)   { return 3; }
+    );
+
+    auto partial = ni::matcher
+    (   [](MouseDown const&)  { return 1; }
+    ,   [](KeyEvent const&)   { return 3; }
+    );
+
+    Event const& e_up = up;
+    Event const& e_down = down;
+    Event const& e_key = key;
+
+    static_assert( std::is_same<int, decltype(exhaustive(e_up))>::value, "" );
+    static_assert( std::is_same<boost::optional<int>, decltype(partial(e_up))>::value, "" );
+
+    EXPECT_EQ( 2, exhaustive(e_up) );
+    EXPECT_EQ( 1, exhaustive(e_down) );
+    EXPECT_EQ( 3, exhaustive(e_key) );
+    EXPECT_FALSE( partial(e_up) );
+    EXPECT_EQ( 3, *partial(e_key) );
+
+    // only the types below the static type need a case
+    MouseEvent const& m_up = up;
+    auto mouse_only = ni::matcher
+    (   [](MouseUp const&)   { return 1; }
+    ,   [](MouseDown const&) { return 2; }
+    );
+    static_assert( std::is_same<int, decltype(mouse_only(m_up))>::value, "" );
+    EXPECT_EQ( 1, mouse_only(m_up) );
+    EXPECT_TRUE( ni::match(e_key)( [](Event const&) {} ) );
+
+    // open hierarchies never match exhaustively
+    OpenChild child;
+    Open& open = child;
+    auto open_matcher = ni::matcher( [](OpenChild&) { return 1; } );
+    static_assert( std::is_same<boost::optional<int>, decltype(open_matcher(open))>::value, "" );
+    EXPECT_EQ( 1, *open_matcher(open) );
+}